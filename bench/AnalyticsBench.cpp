@@ -0,0 +1,127 @@
+#include "Bench.hpp"
+#include "analytics/WorkoutAnalyzer.hpp"
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Workout analytics on a synthetic pose stream: 30 fps of bottom/middle/top
+ * poses forming 2 s reps, a jog every 50 frames and a rest between sets.
+ * App feeds one AnalyzerShard per ingress thread, so the shard variant is
+ * the cost each command pays there; the locked variant is the shared
+ * analyzer it replaced.
+ */
+
+namespace {
+
+constexpr uint64_t kFramesPerRep = 60;
+constexpr uint64_t kRepsPerSet = 10;
+
+// What poseStream(n) contains: a rep completes when it is back at the
+// bottom, 50 frames in, and every 50th frame is a jog instead of a pose.
+struct Expected {
+    uint64_t reps;
+    uint64_t sets;
+    uint64_t shifts;
+};
+
+Expected expected(uint64_t n) {
+    const uint64_t reps = n / kFramesPerRep + (n % kFramesPerRep > 50 ? 1 : 0);
+    return {reps, (reps + kRepsPerSet - 1) / kRepsPerSet, n / 50};
+}
+
+std::vector<proto::Command> poseStream(uint64_t n) {
+    // 60 frames per rep: hold bottom, rise, hold top, lower.
+    static constexpr int kRep[] = {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+                                   4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+                                   3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2};
+    constexpr uint64_t kFrameNs = 33333333;
+    constexpr uint64_t kRestNs = 60000000000ull;
+
+    std::vector<proto::Command> out(n);
+    uint64_t t = 1000000000ull;
+    for (uint64_t i = 0; i < n; ++i) {
+        proto::Command& cmd = out[i];
+        const uint64_t frame = i % kFramesPerRep;
+        if (i % 50 == 49) {
+            cmd.op = proto::Op::StepperJog;
+            cmd.arg = (i / 50) & 1 ? 1 : -1;
+        } else {
+            cmd.op = proto::Op::ServoPose;
+            cmd.arg = kRep[frame];
+        }
+        t += kFrameNs;
+        if (frame == 0 && i != 0 && (i / kFramesPerRep) % kRepsPerSet == 0) t += kRestNs;
+        cmd.rxNs = t;
+    }
+    return out;
+}
+
+template <class Sink, class Feed>
+void run(bench::Reporter& r, const char* name, Feed&& feed) {
+    const uint64_t n = r.iters(5000000);
+    std::vector<proto::Command> events = poseStream(n);
+    Sink sink;
+
+    uint64_t a0 = bench::allocations();
+    double ns = bench::timeLoop(n, [&](uint64_t i) { feed(sink, events[i]); });
+    uint64_t allocs = bench::allocations() - a0;
+
+    analytics::WorkoutAnalyzer analyzer;
+    if constexpr (std::is_same_v<Sink, analytics::AnalyzerShard>) sink.snapshot(analyzer);
+    else analyzer = sink;
+
+    const analytics::Totals& t = analyzer.totals();
+    const Expected want = expected(n);
+    r.add(name)
+        .set("events", double(n))
+        .set("ns_per_op", ns)
+        .set("allocs_per_op", double(allocs) / double(n))
+        .set("reps", double(t.reps))
+        .set("sets", double(analyzer.sets()))
+        .check("reps_detected", t.reps == want.reps && t.partials == 0)
+        .check("sets_detected", analyzer.sets() == want.sets)
+        .check("shifts_detected", analyzer.lateralShifts() == want.shifts);
+}
+
+} // namespace
+
+WT_BENCH("analytics/on_command") {
+    run<analytics::WorkoutAnalyzer>(r, "analytics/on_command",
+        [](analytics::WorkoutAnalyzer& a, const proto::Command& cmd) { a.onCommand(cmd); });
+}
+
+WT_BENCH("analytics/on_command_shard") {
+    run<analytics::AnalyzerShard>(r, "analytics/on_command_shard",
+        [](analytics::AnalyzerShard& a, const proto::Command& cmd) { a.onCommand(cmd); });
+}
+
+WT_BENCH("analytics/on_command_locked") {
+    std::mutex mutex;
+    run<analytics::WorkoutAnalyzer>(r, "analytics/on_command_locked", [&](analytics::WorkoutAnalyzer& a, const proto::Command& cmd) {
+        std::lock_guard<std::mutex> lock(mutex);
+        a.onCommand(cmd);
+    });
+}
+
+WT_BENCH("analytics/tracked_actuator") {
+    // A second limb on id 1, half a rep out of phase, must not disturb the count for id 0.
+    const uint64_t n = r.iters(600000);
+    std::vector<proto::Command> events = poseStream(n);
+    analytics::WorkoutAnalyzer alone;
+    analytics::WorkoutAnalyzer mixed;
+    for (uint64_t i = 0; i < n; ++i) {
+        alone.onCommand(events[i]);
+        mixed.onCommand(events[i]);
+        proto::Command other = events[(i + 30) % n];
+        other.actuator = 1;
+        other.rxNs = events[i].rxNs;
+        mixed.onCommand(other);
+    }
+
+    r.add("analytics/tracked_actuator")
+        .set("reps", double(mixed.totals().reps))
+        .check("other_ids_ignored", mixed.totals().reps == alone.totals().reps &&
+                                        mixed.totals().partials == alone.totals().partials &&
+                                        mixed.lateralShifts() == alone.lateralShifts());
+}
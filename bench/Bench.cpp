@@ -0,0 +1,187 @@
+#include "Bench.hpp"
+#include "hal/Backend.hpp"
+#include "util/Log.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <unistd.h>
+
+/* ---------------- allocation counting ---------------- */
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+}
+
+void* operator new(std::size_t n) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace bench {
+
+uint64_t allocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+/* ---------------- results ---------------- */
+
+Result& Result::set(const std::string& key, double value) {
+    fields.emplace_back(key, value);
+    return *this;
+}
+
+Result& Result::latency(const std::string& prefix, const util::LatencyHistogram& h) {
+    set(prefix + "_count", double(h.count()));
+    set(prefix + "_mean_ns", double(h.mean()));
+    set(prefix + "_p50_ns", double(h.percentile(50)));
+    set(prefix + "_p90_ns", double(h.percentile(90)));
+    set(prefix + "_p99_ns", double(h.percentile(99)));
+    set(prefix + "_max_ns", double(h.max()));
+    return *this;
+}
+
+Result& Result::check(const std::string& what, bool ok) {
+    set("check_" + what, ok ? 1.0 : 0.0);
+    if (!ok) failedChecks.push_back(what);
+    return *this;
+}
+
+Result& Reporter::add(std::string name) {
+    results_.push_back({std::move(name), {}, {}});
+    return results_.back();
+}
+
+/* ---------------- registry ---------------- */
+
+namespace {
+
+struct Case {
+    const char* name;
+    CaseFn fn;
+};
+
+std::vector<Case>& cases() {
+    static std::vector<Case> all;
+    return all;
+}
+
+void writeJson(std::ostream& out, const std::string& label, const Options& opts,
+               const std::vector<Result>& results) {
+    char host[64] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+
+    out << "{\n  \"label\": \"" << label << "\",\n"
+        << "  \"host\": \"" << host << "\",\n"
+        << "  \"build_type\": \"" << WT_BENCH_BUILD_TYPE << "\",\n"
+        << "  \"cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"simulated_gpio\": " << (hal::kSimulated ? "true" : "false") << ",\n"
+        << "  \"quick\": " << (opts.quick ? "true" : "false") << ",\n"
+        << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\"";
+        for (const auto& [key, value] : r.fields) {
+            char num[32];
+            std::snprintf(num, sizeof(num), "%.6g", value);
+            out << ", \"" << key << "\": " << num;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0
+              << " [--filter SUBSTR] [--out PATH] [--label TEXT] [--tmp DIR] [--replay-log LOG] [--quick] [--list]\n";
+}
+
+} // namespace
+
+bool registerCase(const char* name, CaseFn fn) {
+    cases().push_back({name, fn});
+    return true;
+}
+
+} // namespace bench
+
+int main(int argc, char** argv) {
+    bench::Options opts;
+    opts.tmpDir = access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+    std::vector<std::string> filters;
+    std::string outPath;
+    std::string label;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filters.emplace_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else if (std::strcmp(argv[i], "--tmp") == 0 && i + 1 < argc) {
+            opts.tmpDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay-log") == 0 && i + 1 < argc) {
+            opts.replayLog = argv[++i];
+        } else if (std::strcmp(argv[i], "--quick") == 0) {
+            opts.quick = true;
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else {
+            bench::usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Controllers and App log to stdout; keep stdout for the JSON report.
+    logging::setOutput(stderr, stderr);
+    std::streambuf* stdoutBuf = std::cout.rdbuf(std::cerr.rdbuf());
+
+    bench::Reporter reporter(opts);
+    for (const auto& c : bench::cases()) {
+        bool selected = filters.empty();
+        for (const auto& f : filters) selected |= std::strstr(c.name, f.c_str()) != nullptr;
+        if (!selected) continue;
+        if (list) {
+            std::cerr << c.name << "\n";
+            continue;
+        }
+        std::cerr << "[bench] " << c.name << "\n";
+        try {
+            c.fn(reporter);
+        } catch (const std::exception& e) {
+            std::cerr << "[bench] " << c.name << " failed: " << e.what() << "\n";
+            reporter.add(c.name).set("failed", 1).failedChecks.push_back("completes");
+        }
+    }
+    if (list) return 0;
+
+    int failures = 0;
+    for (const bench::Result& r : reporter.results()) {
+        for (const std::string& what : r.failedChecks) {
+            std::cerr << "[bench] FAILED " << r.name << ": " << what << "\n";
+            ++failures;
+        }
+    }
+
+    std::cout.rdbuf(stdoutBuf);
+    if (outPath.empty()) {
+        bench::writeJson(std::cout, label, opts, reporter.results());
+    } else {
+        std::ofstream out(outPath);
+        bench::writeJson(out, label, opts, reporter.results());
+        std::cerr << "[bench] Wrote " << reporter.results().size() << " results to " << outPath << "\n";
+    }
+    return failures ? 2 : 0;
+}
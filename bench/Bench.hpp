@@ -0,0 +1,91 @@
+#pragma once
+#include "util/LatencyHistogram.hpp"
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Minimal benchmark harness for workout-tracker-bench.
+ *
+ * Each case registers itself with WT_BENCH(name) and reports one or more
+ * Results: a name plus numeric fields (ns_per_op, p99_ns, ...). The driver
+ * in Bench.cpp runs the selected cases and writes every Result as JSON so
+ * runs from different commits can be diffed (see bench/compare.py).
+ * Cases may also check() a bound; any failed check (or a case that
+ * throws) makes the run exit non-zero.
+ *
+ * Benchmarks always build against the simulated GPIO backend; PWM writes
+ * that need a real file use hal::SysfsPwm on a tmpfs directory.
+ */
+namespace bench {
+
+struct Result {
+    std::string name;
+    std::vector<std::pair<std::string, double>> fields;
+    std::vector<std::string> failedChecks;
+
+    Result& set(const std::string& key, double value);
+    // p50/p90/p99/max/mean of a histogram, as <prefix>_p50_ns etc.
+    Result& latency(const std::string& prefix, const util::LatencyHistogram& h);
+    // Recorded as check_<what> = 1 or 0; a 0 fails the run.
+    Result& check(const std::string& what, bool ok);
+};
+
+struct Options {
+    bool quick = false;   // shorter runs, for smoke checks
+    std::string tmpDir;   // tmpfs scratch directory for fake sysfs trees and rings
+    std::string replayLog;  // captured session for replay/*; synthetic when empty
+};
+
+class Reporter {
+public:
+    explicit Reporter(const Options& opts) : opts_(opts) {}
+
+    Result& add(std::string name);
+    const Options& options() const { return opts_; }
+    // Scale an iteration count down for --quick runs.
+    uint64_t iters(uint64_t full) const { return opts_.quick ? (full / 10 ? full / 10 : 1) : full; }
+
+    const std::vector<Result>& results() const { return results_; }
+
+private:
+    const Options& opts_;
+    std::vector<Result> results_;
+};
+
+using CaseFn = void (*)(Reporter&);
+bool registerCase(const char* name, CaseFn fn);
+
+#define WT_BENCH_CAT2(a, b) a##b
+#define WT_BENCH_CAT(a, b) WT_BENCH_CAT2(a, b)
+#define WT_BENCH(name)                                                         \
+    static void WT_BENCH_CAT(benchCase_, __LINE__)(::bench::Reporter&);        \
+    static const bool WT_BENCH_CAT(benchReg_, __LINE__) =                      \
+        ::bench::registerCase(name, &WT_BENCH_CAT(benchCase_, __LINE__));      \
+    static void WT_BENCH_CAT(benchCase_, __LINE__)(::bench::Reporter & r)
+
+/** Heap allocations made by this process so far (global operator new is counted). */
+uint64_t allocations();
+
+template <class T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline uint64_t nowNs() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+/** Run fn() iters times; returns the mean cost of one call in ns. */
+template <class F>
+double timeLoop(uint64_t iters, F&& fn) {
+    uint64_t t0 = nowNs();
+    for (uint64_t i = 0; i < iters; ++i) fn(i);
+    return double(nowNs() - t0) / double(iters);
+}
+
+} // namespace bench
@@ -0,0 +1,68 @@
+#include "Bench.hpp"
+#include "app/ActuatorRegistry.hpp"
+#include "util/Metrics.hpp"
+#include <random>
+#include <vector>
+
+/*
+ * ActuatorRegistry::dispatch() throughput as the number of actuators grows.
+ * Half are steppers and half servos, each on its own id, and the commands
+ * hit them in random order. The controllers are not started, so each
+ * dispatch ends in a queue push; ns/op should stay flat from 2 to 32.
+ */
+
+namespace {
+
+std::vector<ActuatorSpec> layout(size_t actuators) {
+    std::vector<ActuatorSpec> specs;
+    for (size_t i = 0; i < actuators; ++i) {
+        ActuatorSpec spec;
+        spec.id = uint8_t(i);
+        spec.name = "a" + std::to_string(i);
+        if (i % 2 == 0) {
+            spec.kind = ActuatorSpec::Kind::Stepper;
+            spec.chip = "bench";
+            spec.lines = {105, 106, 41, 43};
+        } else {
+            spec.kind = ActuatorSpec::Kind::Servo;
+            spec.pwmChip = "bench";
+        }
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+std::vector<proto::Command> commands(size_t actuators) {
+    static constexpr proto::Op kStepperOps[] = {proto::Op::StepperJog, proto::Op::StepperMoveTo,
+                                                proto::Op::StepperMoveBy, proto::Op::StepperStop};
+    static constexpr proto::Op kServoOps[] = {proto::Op::ServoPose, proto::Op::ServoAngle};
+    std::mt19937 rng(11);
+    std::vector<proto::Command> out(4096);
+    for (proto::Command& cmd : out) {
+        cmd.actuator = uint8_t(rng() % actuators);
+        cmd.op = cmd.actuator % 2 == 0 ? kStepperOps[rng() % 4] : kServoOps[rng() % 2];
+        cmd.arg = cmd.op == proto::Op::ServoPose ? int32_t(2 + rng() % 3) : int32_t(1 + rng() % 999);
+        cmd.rxNs = 1;
+    }
+    return out;
+}
+
+} // namespace
+
+WT_BENCH("dispatch/registry") {
+    const uint64_t n = r.iters(2000000);
+    for (size_t actuators : {2, 4, 8, 16, 32}) {
+        ActuatorRegistry registry(layout(actuators));
+        const std::vector<proto::Command> cmds = commands(actuators);
+
+        uint64_t a0 = bench::allocations();
+        double ns = bench::timeLoop(n, [&](uint64_t i) { registry.dispatch(cmds[i & (cmds.size() - 1)]); });
+        uint64_t allocs = bench::allocations() - a0;
+
+        r.add("dispatch/registry_" + std::to_string(actuators))
+            .set("actuators", double(actuators))
+            .set("ns_per_op", ns)
+            .set("allocs_per_op", double(allocs) / double(n));
+    }
+    metrics::registry().reset();
+}
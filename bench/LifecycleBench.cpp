@@ -0,0 +1,227 @@
+#include "Bench.hpp"
+#include "app/ActuatorRegistry.hpp"
+#include "app/App.hpp"
+#include "control/ServoController.hpp"
+#include "control/StepperController.hpp"
+#include "hal/SysfsPwm.hpp"
+#include "util/Clock.hpp"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+/*
+ * Startup-to-ready and stop-to-exit of a full App on the simulated
+ * backends, actuator bring-up with the simulator's setup delays turned on,
+ * plus the sysfs export wait and read-back against a fake PWM tree.
+ */
+
+WT_BENCH("lifecycle/app_start_stop") {
+    const uint64_t rounds = r.iters(50);
+    util::LatencyHistogram startNs;
+    util::LatencyHistogram stopNs;
+    StartupTiming sum;
+
+    for (uint64_t i = 0; i < rounds; ++i) {
+        AppConfig cfg;
+        cfg.port = 0;  // any free port; nothing connects
+        cfg.statsSocketPath.clear();
+
+        uint64_t t0 = util::monotonicNs();
+        App app(cfg);
+        app.init();
+        app.start();
+        uint64_t t1 = util::monotonicNs();
+        startNs.record(t1 - t0);
+        const StartupTiming& st = app.startupTiming();
+        sum.initNs += st.initNs;
+        sum.actuatorsNs += st.actuatorsNs;
+        sum.listenNs += st.listenNs;
+        sum.readyNs += st.readyNs;
+
+        // Let every thread settle into its idle wait first.
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        uint64_t t2 = util::monotonicNs();
+        app.stop();
+        stopNs.record(util::monotonicNs() - t2);
+    }
+
+    const double n = double(rounds);
+    r.add("lifecycle/app_start_stop")
+        .latency("start", startNs)
+        .latency("stop", stopNs)
+        .set("init_ns_mean", double(sum.initNs) / n)
+        .set("actuators_ns_mean", double(sum.actuatorsNs) / n)
+        .set("listen_ns_mean", double(sum.listenNs) / n)
+        .set("ready_ns_mean", double(sum.readyNs) / n);
+}
+
+WT_BENCH("lifecycle/actuator_bringup") {
+    // Two steppers and two servos with bring-up delays in the range real
+    // hardware shows: a line request, a PWM export waiting on udev, and a
+    // sysfs write each. One at a time is how startup used to go; the
+    // registry brings them up concurrently; the "restart" case finds the
+    // PWM channels still configured, as after a crash.
+    std::vector<ActuatorSpec> specs = defaultActuators();
+    specs.push_back(specs[0]);
+    specs.push_back(specs[1]);
+    specs[2].name = "stepper2";
+    specs[2].id = 1;
+    specs[3].name = "servo2";
+    specs[3].id = 1;
+    specs[3].channel = 1;
+    hal::setSimSetupLatency({2000, 20000, 500});
+
+    const uint64_t rounds = r.iters(10);
+    util::LatencyHistogram sequentialNs, concurrentNs, restartNs;
+    unsigned restartWrites = 0;  // summed over every round
+    for (uint64_t i = 0; i < rounds; ++i) {
+        {
+            std::vector<std::unique_ptr<StepperController>> steppers;
+            std::vector<std::unique_ptr<ServoController>> servos;
+            for (const ActuatorSpec& s : specs) {
+                if (s.kind == ActuatorSpec::Kind::Stepper) {
+                    steppers.push_back(std::make_unique<StepperController>(s.lines, s.chip, s.timing, s.drive));
+                } else {
+                    servos.push_back(std::make_unique<ServoController>(s.pwmChip, s.channel, s.motion));
+                }
+            }
+            uint64_t t0 = util::monotonicNs();
+            for (auto& s : steppers) s->startPolled();
+            for (auto& s : servos) s->startPolled();
+            sequentialNs.record(util::monotonicNs() - t0);
+        }
+        {
+            ActuatorRegistry reg(specs);
+            uint64_t t0 = util::monotonicNs();
+            reg.startPolled();
+            concurrentNs.record(util::monotonicNs() - t0);
+        }
+        {
+            // A process that died with its channels configured never closes them.
+            for (const ActuatorSpec& s : specs) {
+                if (s.kind == ActuatorSpec::Kind::Servo) hal::SimPwm(s.pwmChip, s.channel, 1).open(20000000, 2500000);
+            }
+            ActuatorRegistry reg(specs);
+            uint64_t t0 = util::monotonicNs();
+            reg.startPolled();
+            restartNs.record(util::monotonicNs() - t0);
+            for (const auto& s : reg.servos()) restartWrites += s.controller->pwm().setupWrites();
+        }
+    }
+    hal::setSimSetupLatency({});
+
+    r.add("lifecycle/actuator_bringup")
+        .latency("sequential", sequentialNs)
+        .latency("concurrent", concurrentNs)
+        .latency("restart", restartNs)
+        .set("speedup_p50", double(sequentialNs.percentile(50)) / double(concurrentNs.percentile(50)))
+        .set("restart_speedup_p50", double(sequentialNs.percentile(50)) / double(restartNs.percentile(50)))
+        .set("restart_pwm_writes", double(restartWrites))
+        .check("concurrent_faster", concurrentNs.percentile(50) < sequentialNs.percentile(50))
+        .check("restart_skips_pwm_setup", restartWrites == 0);
+}
+
+WT_BENCH("lifecycle/controller_stop_mid_motion") {
+    // Both controllers moving, so each is asleep on a step or PWM deadline.
+    const uint64_t rounds = r.iters(50);
+    util::LatencyHistogram stepperNs;
+    util::LatencyHistogram servoNs;
+
+    for (uint64_t i = 0; i < rounds; ++i) {
+        StepperController stepper({105, 106, 41, 43}, "bench");
+        ServoController servo("bench", 0);
+        stepper.start();
+        servo.start();
+        stepper.pushCommand({StepperCommand::Kind::MoveTo, 100000});
+        servo.pushAngle(0);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+        uint64_t t0 = util::monotonicNs();
+        servo.stop();
+        uint64_t t1 = util::monotonicNs();
+        stepper.stop();
+        stepperNs.record(util::monotonicNs() - t1);
+        servoNs.record(t1 - t0);
+    }
+
+    r.add("lifecycle/controller_stop_mid_motion").latency("stepper_stop", stepperNs).latency("servo_stop", servoNs);
+}
+
+WT_BENCH("lifecycle/pwm_export_wait") {
+    // The "kernel" creates pwm0 a fixed delay after export; open() should
+    // return shortly after that instead of after a flat sleep.
+    namespace fs = std::filesystem;
+    constexpr auto kAppearAfter = std::chrono::milliseconds(3);
+    const uint64_t rounds = r.iters(20);
+    fs::path root = fs::path(r.options().tmpDir) / ("wt-bench-export-" + std::to_string(getpid()));
+    util::LatencyHistogram openNs;
+
+    for (uint64_t i = 0; i < rounds; ++i) {
+        fs::path chip = root / "pwmchip0";
+        fs::remove_all(root);
+        fs::create_directories(chip);
+        std::ofstream(chip / "export") << "";
+
+        std::thread kernel([&] {
+            std::this_thread::sleep_for(kAppearAfter);
+            fs::create_directories(chip / "pwm0");
+            for (const char* attr : {"period", "duty_cycle", "enable"}) std::ofstream(chip / "pwm0" / attr) << "0";
+        });
+
+        uint64_t t0 = util::monotonicNs();
+        {
+            hal::SysfsPwm pwm(chip.string(), 0);
+            pwm.open(20000000, 2500000);
+            openNs.record(util::monotonicNs() - t0);
+        }
+        kernel.join();
+    }
+    fs::remove_all(root);
+
+    r.add("lifecycle/pwm_export_wait")
+        .set("appear_after_ns", double(std::chrono::nanoseconds(kAppearAfter).count()))
+        .latency("open", openNs);
+}
+
+WT_BENCH("lifecycle/pwm_reopen") {
+    // A channel left exported and configured: open() reads it back and
+    // writes nothing. A stale one gets exactly the attributes that differ.
+    namespace fs = std::filesystem;
+    fs::path root = fs::path(r.options().tmpDir) / ("wt-bench-reopen-" + std::to_string(getpid()));
+    fs::path pwm0 = root / "pwmchip0" / "pwm0";
+    auto leave = [&](const char* period, const char* duty, const char* enable) {
+        fs::remove_all(root);
+        fs::create_directories(pwm0);
+        std::ofstream(root / "pwmchip0" / "export") << "";
+        std::ofstream(pwm0 / "period") << period;
+        std::ofstream(pwm0 / "duty_cycle") << duty;
+        std::ofstream(pwm0 / "enable") << enable;
+    };
+
+    const uint64_t rounds = r.iters(200);
+    util::LatencyHistogram configuredNs, staleNs;
+    unsigned configuredWrites = 0, staleWrites = 0;
+    for (uint64_t i = 0; i < rounds; ++i) {
+        leave("20000000\n", "2500000\n", "1\n");
+        hal::SysfsPwm configured((root / "pwmchip0").string(), 0);
+        uint64_t t0 = util::monotonicNs();
+        configured.open(20000000, 2500000);
+        configuredNs.record(util::monotonicNs() - t0);
+        configuredWrites = configured.setupWrites();
+
+        leave("20000000\n", "1500000\n", "0\n");
+        hal::SysfsPwm stale((root / "pwmchip0").string(), 0);
+        t0 = util::monotonicNs();
+        stale.open(20000000, 2500000);
+        staleNs.record(util::monotonicNs() - t0);
+        staleWrites = stale.setupWrites();
+    }
+    fs::remove_all(root);
+
+    r.add("lifecycle/pwm_reopen")
+        .latency("configured_open", configuredNs)
+        .latency("stale_open", staleNs)
+        .set("configured_writes", double(configuredWrites))
+        .set("stale_writes", double(staleWrites));
+}
@@ -0,0 +1,134 @@
+#include "Bench.hpp"
+#include "util/Log.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/*
+ * Per-call cost of the async logger on the writing thread, against the
+ * std::ostream path it replaced. Records are written in bursts of half a
+ * ring and drained to /dev/null between bursts, outside the timed region,
+ * so no record is dropped; log/async_full measures the drop path instead.
+ * The ostream baseline also writes to /dev/null, so it leaves out the
+ * terminal or journald I/O that made std::cout expensive in the first place.
+ */
+
+namespace {
+
+constexpr size_t kBurst = 512;
+
+struct DevNull {
+    FILE* f = std::fopen("/dev/null", "w");
+    DevNull() { logging::setOutput(f, f); }
+    ~DevNull() {
+        logging::setOutput(stderr, stderr);
+        std::fclose(f);
+    }
+};
+
+// Mean and per-call latency of fn(i) in flushed bursts.
+template <class F>
+void bursts(bench::Reporter& r, const char* name, uint64_t calls, F&& fn) {
+    DevNull sink;
+    logging::flush();
+    const uint64_t dropped0 = logging::dropped();
+
+    uint64_t timedNs = 0;
+    for (uint64_t done = 0; done < calls; done += kBurst) {
+        uint64_t t0 = bench::nowNs();
+        for (size_t i = 0; i < kBurst; ++i) fn(done + i);
+        timedNs += bench::nowNs() - t0;
+        logging::flush();
+    }
+    util::LatencyHistogram perCall;
+    for (uint64_t done = 0; done < calls / 10; done += kBurst) {
+        for (size_t i = 0; i < kBurst; ++i) {
+            uint64_t t0 = bench::nowNs();
+            fn(done + i);
+            perCall.record(bench::nowNs() - t0);
+        }
+        logging::flush();
+    }
+
+    const uint64_t n = (calls + kBurst - 1) / kBurst * kBurst;
+    r.add(name)
+        .set("ns_per_call", double(timedNs) / double(n))
+        .set("dropped", double(logging::dropped() - dropped0))
+        .latency("call", perCall);
+}
+
+} // namespace
+
+WT_BENCH("log/async_ints") {
+    bursts(r, "log/async_ints", r.iters(2000000), [](uint64_t i) {
+        logging::warn(logging::Event::AppNotRouted, int(i & 0xff), int(i & 7));
+    });
+}
+
+WT_BENCH("log/async_string") {
+    const std::string path = "/sys/class/pwm/pwmchip0/pwm0";
+    bursts(r, "log/async_string", r.iters(2000000), [&](uint64_t) {
+        logging::info(logging::Event::ServoStarted, path);
+    });
+}
+
+WT_BENCH("log/ostream_baseline") {
+    std::ofstream devNull("/dev/null");
+    std::streambuf* saved = std::cout.rdbuf(devNull.rdbuf());
+    const uint64_t n = r.iters(2000000);
+    double ns = bench::timeLoop(n, [](uint64_t i) {
+        std::cout << "[app] No actuator " << int(i & 0xff) << " for op " << int(i & 7) << "; dropped\n";
+    });
+    std::cout.flush();
+    std::cout.rdbuf(saved);
+    r.add("log/ostream_baseline").set("ns_per_call", ns);
+}
+
+WT_BENCH("log/async_full") {
+    // No drain between calls: after the first ring's worth every call is a
+    // counted drop, which is what a hot thread pays when logging outruns I/O.
+    DevNull sink;
+    const uint64_t n = r.iters(2000000);
+    const uint64_t dropped0 = logging::dropped();
+    double ns = 0.0;
+    std::thread writer([&] {
+        ns = bench::timeLoop(n, [](uint64_t i) {
+            logging::warn(logging::Event::AppNotRouted, int(i & 0xff), int(i & 7));
+        });
+    });
+    writer.join();
+    logging::flush();
+    r.add("log/async_full")
+        .set("ns_per_call", ns)
+        .set("dropped_fraction", double(logging::dropped() - dropped0) / double(n));
+}
+
+WT_BENCH("log/async_4_threads") {
+    // Each thread owns its ring, so writers never contend with each other.
+    DevNull sink;
+    const uint64_t n = r.iters(200000);
+    const uint64_t dropped0 = logging::dropped();
+    std::vector<double> ns(4);
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < ns.size(); ++t) {
+        writers.emplace_back([&, t] {
+            uint64_t total = 0;
+            for (uint64_t done = 0; done < n; done += 256) {
+                uint64_t t0 = bench::nowNs();
+                for (uint64_t i = 0; i < 256; ++i) logging::warn(logging::Event::AppNotRouted, int(t), int(i));
+                total += bench::nowNs() - t0;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));  // let the drain thread keep up
+            }
+            ns[t] = double(total) / double(n);
+        });
+    }
+    for (auto& w : writers) w.join();
+    logging::flush();
+    double mean = 0.0;
+    for (double v : ns) mean += v / double(ns.size());
+    r.add("log/async_4_threads")
+        .set("ns_per_call", mean)
+        .set("dropped", double(logging::dropped() - dropped0));
+}
@@ -0,0 +1,294 @@
+#include "Bench.hpp"
+#include "app/App.hpp"
+#include "app/CommandProtocol.hpp"
+#include "comm/shm_ring_writer.h"
+#include "util/Clock.hpp"
+#include "util/Metrics.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * Macrobenchmarks: a full App (simulated actuators) fed a synthetic pose
+ * stream over loopback TCP or the shared-memory ring, either paced like a
+ * camera (macro/loopback_*, macro/shm_ring) or unpaced from several
+ * clients at once to find what App sustains (macro/load_*). Latencies come from
+ * the App's own metrics registry, so they are the same numbers the stats
+ * endpoint would report in the field.
+ */
+
+namespace {
+
+constexpr uint64_t kStreamHz = 500;  // well above the camera rate, to load the path
+constexpr size_t kLoadClients = 4;
+constexpr size_t kLoadBurst = 32;    // commands per send() in the load cases
+
+int freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || getsockname(fd, (sockaddr*)&addr, &len) < 0) {
+        throw std::runtime_error("no free loopback port");
+    }
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+int connectWithRetry(int port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(uint16_t(port));
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    throw std::runtime_error("App did not start listening");
+}
+
+// Mostly servo poses with a stepper jog every tenth command.
+proto::Op opFor(uint64_t i) {
+    return i % 10 == 9 ? proto::Op::StepperJog : proto::Op::ServoPose;
+}
+int32_t argFor(uint64_t i) {
+    return i % 10 == 9 ? ((i / 10) & 1 ? 1 : -1) : int32_t(2 + i % 3);
+}
+char legacyFor(uint64_t i) {
+    return i % 10 == 9 ? ((i / 10) & 1 ? 'R' : 'L') : char('2' + i % 3);
+}
+
+void sleepUntil(uint64_t deadlineNs) {
+    timespec ts{time_t(deadlineNs / 1000000000ull), long(deadlineNs % 1000000000ull)};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+void sendAll(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n <= 0) throw std::runtime_error("send failed");
+        p += n;
+        len -= size_t(n);
+    }
+}
+
+AppConfig benchConfig(const bench::Reporter& r) {
+    AppConfig cfg;
+    cfg.port = freePort();
+    cfg.statsSocketPath = r.options().tmpDir + "/wt-bench-" + std::to_string(getpid()) + ".stats";
+    return cfg;
+}
+
+// Process-wide CPU time and context switches; includes the sender thread,
+// which costs the same in every variant.
+struct Usage {
+    double cpuNs = 0;
+    double switches = 0;
+
+    static Usage now() {
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        Usage u;
+        u.cpuNs = double(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e9 +
+                  double(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e3;
+        u.switches = double(ru.ru_nvcsw + ru.ru_nivcsw);
+        return u;
+    }
+};
+
+bench::Result& report(bench::Reporter& r, const char* name, uint64_t sent, uint64_t elapsedNs,
+                      const Usage& before) {
+    Usage after = Usage::now();
+    double secs = double(elapsedNs) / 1e9;
+    auto& m = metrics::registry();
+    auto& res = r.add(name)
+                    .set("cpu_ms_per_sec", (after.cpuNs - before.cpuNs) / 1e6 / secs)
+                    .set("ctxsw_per_sec", (after.switches - before.switches) / secs)
+                    .set("commands_sent", double(sent))
+                    .set("commands_dispatched", double(m.counter(metrics::Counter::Commands)))
+                    .set("dropped", double(m.counter(metrics::Counter::Stale) + m.counter(metrics::Counter::OutOfOrder)))
+                    .set("commands_per_sec", double(sent) * 1e9 / double(elapsedNs));
+    for (size_t i = 0; i < metrics::kStages; ++i) {
+        auto stage = metrics::Stage(i);
+        metrics::StageSummary s = m.summary(stage);
+        if (s.count == 0) continue;
+        std::string prefix = metrics::name(stage);
+        res.set(prefix + "_count", double(s.count))
+            .set(prefix + "_p50_ns", double(s.p50))
+            .set(prefix + "_p99_ns", double(s.p99))
+            .set(prefix + "_max_ns", double(s.max));
+    }
+    return res;
+}
+
+// Stream n commands at kStreamHz through send(i), then let the controllers drain.
+template <class F>
+uint64_t paced(uint64_t n, F&& send) {
+    const uint64_t period = 1000000000ull / kStreamHz;
+    uint64_t t0 = util::monotonicNs();
+    for (uint64_t i = 0; i < n; ++i) {
+        sleepUntil(t0 + i * period);
+        send(i);
+    }
+    uint64_t elapsed = util::monotonicNs() - t0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return elapsed;
+}
+
+void tcpStream(bench::Reporter& r, const char* name, bool binary, ExecMode mode = ExecMode::Threaded) {
+    const uint64_t n = r.iters(2000);
+    AppConfig cfg = benchConfig(r);
+    cfg.execMode = mode;
+    metrics::registry().reset();
+
+    App app(cfg);
+    app.init();
+    app.start();
+    int fd = connectWithRetry(cfg.port);
+    Usage before = Usage::now();
+
+    uint64_t elapsed;
+    if (binary) {
+        sendAll(fd, &proto::kNegotiateBinary, 1);
+        elapsed = paced(n, [&](uint64_t i) {
+            uint8_t frame[proto::kHeaderSize];
+            proto::writeHeader(frame, opFor(i), 0, argFor(i), uint32_t(i + 1), util::monotonicNs());
+            sendAll(fd, frame, sizeof(frame));
+        });
+    } else {
+        elapsed = paced(n, [&](uint64_t i) {
+            char c = legacyFor(i);
+            sendAll(fd, &c, 1);
+        });
+    }
+    close(fd);
+
+    report(r, name, n, elapsed, before);
+    app.stop();
+}
+
+// Every client sends its share as fast as its socket takes it. The rate is
+// taken up to the last dispatch, so it is what App sustains, not what was offered.
+void tcpLoad(bench::Reporter& r, const char* name, bool binary, ExecMode mode = ExecMode::Threaded) {
+    const uint64_t perClient = r.iters(50000);
+    const uint64_t total = perClient * kLoadClients;
+    AppConfig cfg = benchConfig(r);
+    cfg.execMode = mode;
+    cfg.maxFrameAgeMs = 0;  // a backed-up socket is the point here, not a stale sender
+    metrics::registry().reset();
+
+    App app(cfg);
+    app.init();
+    app.start();
+    std::vector<int> fds;
+    for (size_t c = 0; c < kLoadClients; ++c) fds.push_back(connectWithRetry(cfg.port));
+    Usage before = Usage::now();
+
+    const uint64_t t0 = util::monotonicNs();
+    std::vector<std::thread> clients;
+    for (int fd : fds) {
+        clients.emplace_back([&, fd] {
+            std::vector<uint8_t> buf;
+            if (binary) sendAll(fd, &proto::kNegotiateBinary, 1);
+            for (uint64_t i = 0; i < perClient; i += kLoadBurst) {
+                buf.clear();
+                for (uint64_t j = i; j < std::min<uint64_t>(perClient, i + kLoadBurst); ++j) {
+                    if (binary) {
+                        buf.resize(buf.size() + proto::kHeaderSize);
+                        proto::writeHeader(buf.data() + buf.size() - proto::kHeaderSize, opFor(j), 0, argFor(j),
+                                           uint32_t(j + 1), util::monotonicNs());
+                    } else {
+                        buf.push_back(uint8_t(legacyFor(j)));
+                    }
+                }
+                sendAll(fd, buf.data(), buf.size());
+            }
+        });
+    }
+    for (auto& c : clients) c.join();
+
+    auto& m = metrics::registry();
+    const uint64_t deadline = util::monotonicNs() + 10000000000ull;
+    while (m.counter(metrics::Counter::Commands) < total && util::monotonicNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const uint64_t elapsed = util::monotonicNs() - t0;
+    const uint64_t dispatched = m.counter(metrics::Counter::Commands);
+    for (int fd : fds) close(fd);
+
+    report(r, name, total, elapsed, before)
+        .set("clients", double(kLoadClients))
+        .set("controller_dropped", double(m.counter(metrics::Counter::Dropped)))
+        .check("all_dispatched", dispatched == total);
+    app.stop();
+}
+
+} // namespace
+
+WT_BENCH("macro/loopback_legacy") {
+    tcpStream(r, "macro/loopback_legacy", false);
+}
+
+WT_BENCH("macro/loopback_binary") {
+    tcpStream(r, "macro/loopback_binary", true);
+}
+
+WT_BENCH("macro/loopback_binary_reactor") {
+    tcpStream(r, "macro/loopback_binary_reactor", true, ExecMode::Reactor);
+}
+
+WT_BENCH("macro/shm_ring") {
+    const uint64_t n = r.iters(2000);
+    AppConfig cfg = benchConfig(r);
+    cfg.shmRingPath = r.options().tmpDir + "/wt-bench-ring-" + std::to_string(getpid());
+    metrics::registry().reset();
+
+    App app(cfg);
+    app.init();
+    app.start();
+    wt_shm_writer* w = wt_shm_writer_open(cfg.shmRingPath.c_str());
+    if (!w) {
+        app.stop();
+        throw std::runtime_error("cannot attach to " + cfg.shmRingPath);
+    }
+    Usage before = Usage::now();
+
+    uint64_t full = 0;
+    uint64_t elapsed = paced(n, [&](uint64_t i) {
+        full += wt_shm_writer_send(w, uint8_t(opFor(i)), 0, argFor(i), 0) != 0;
+    });
+    wt_shm_writer_close(w);
+
+    report(r, "macro/shm_ring", n, elapsed, before).set("ring_full", double(full));
+    app.stop();
+    unlink(cfg.shmRingPath.c_str());
+}
+
+WT_BENCH("macro/load_legacy") {
+    tcpLoad(r, "macro/load_legacy", false);
+}
+
+WT_BENCH("macro/load_framed") {
+    tcpLoad(r, "macro/load_framed", true);
+}
+
+WT_BENCH("macro/load_framed_reactor") {
+    tcpLoad(r, "macro/load_framed_reactor", true, ExecMode::Reactor);
+}
@@ -0,0 +1,624 @@
+#include "Bench.hpp"
+#include "app/CommandProtocol.hpp"
+#include "control/ServoController.hpp"
+#include "control/StepperController.hpp"
+#include "hal/Sim.hpp"
+#include "hal/SysfsPwm.hpp"
+#include "util/BoundedQueue.hpp"
+#include "util/Clock.hpp"
+#include "util/Metrics.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Legacy byte stream in the mix the inference side actually sends.
+std::vector<char> legacyStream(size_t n) {
+    static constexpr char kCodes[] = {'R', 'L', '2', '3', '4'};
+    std::mt19937 rng(42);
+    std::vector<char> out(n);
+    for (auto& c : out) c = kCodes[rng() % sizeof(kCodes)];
+    return out;
+}
+
+std::vector<uint8_t> frameStream(size_t frames) {
+    std::vector<uint8_t> out(frames * proto::kHeaderSize);
+    for (size_t i = 0; i < frames; ++i) {
+        proto::Op op = (i & 1) ? proto::Op::ServoPose : proto::Op::StepperJog;
+        proto::writeHeader(out.data() + i * proto::kHeaderSize, op, 0, int32_t(2 + i % 3),
+                           uint32_t(i + 1), 1000 + i);
+    }
+    return out;
+}
+
+} // namespace
+
+/* ---------------- command parsing ---------------- */
+
+WT_BENCH("parse/legacy_bytes") {
+    const auto bytes = legacyStream(4096);
+    const uint64_t passes = r.iters(20000);
+    uint64_t decoded = 0;
+    double ns = bench::timeLoop(passes, [&](uint64_t) {
+        proto::Command cmd;
+        for (char c : bytes) decoded += proto::decodeLegacy(c, cmd);
+        bench::doNotOptimize(cmd);
+    });
+    r.add("parse/legacy_bytes")
+        .set("ns_per_op", ns / double(bytes.size()))
+        .set("decoded", double(decoded));
+}
+
+WT_BENCH("parse/binary_frames") {
+    const size_t frames = 4096 / proto::kHeaderSize;
+    const auto buf = frameStream(frames);
+    const uint64_t passes = r.iters(20000);
+    int64_t sum = 0;
+    double ns = bench::timeLoop(passes, [&](uint64_t) {
+        auto res = proto::parseFrames(buf.data(), buf.size(), [&](const proto::FrameView& f) {
+            sum += f.arg() + int64_t(f.seq());
+        });
+        bench::doNotOptimize(res);
+    });
+    bench::doNotOptimize(sum);
+    r.add("parse/binary_frames").set("ns_per_op", ns / double(frames));
+}
+
+/* ---------------- ingress: one-byte reads vs batched reads ---------------- */
+
+namespace {
+
+// Push n legacy bytes through a stream socket and read them back with
+// reads of at most `chunk` bytes; returns ns per byte and syscalls per byte.
+std::pair<double, double> streamIngress(size_t n, size_t chunk) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) throw std::runtime_error("socketpair failed");
+    const auto bytes = legacyStream(n);
+
+    uint64_t t0 = bench::nowNs();
+    std::thread writer([&] {
+        size_t off = 0;
+        while (off < n) {
+            ssize_t w = write(sv[0], bytes.data() + off, std::min<size_t>(4096, n - off));
+            if (w <= 0) break;
+            off += size_t(w);
+        }
+    });
+
+    std::array<char, 4096> buf;
+    size_t got = 0;
+    uint64_t reads = 0;
+    proto::Command cmd;
+    uint64_t decoded = 0;
+    while (got < n) {
+        ssize_t k = read(sv[1], buf.data(), chunk);
+        ++reads;
+        if (k <= 0) break;
+        for (ssize_t i = 0; i < k; ++i) decoded += proto::decodeLegacy(buf[size_t(i)], cmd);
+        got += size_t(k);
+    }
+    uint64_t elapsed = bench::nowNs() - t0;
+    writer.join();
+    close(sv[0]);
+    close(sv[1]);
+    bench::doNotOptimize(decoded);
+    return {double(elapsed) / double(n), double(reads) / double(n)};
+}
+
+} // namespace
+
+WT_BENCH("ingress/one_byte_reads") {
+    auto [ns, syscalls] = streamIngress(r.iters(200000), 1);
+    r.add("ingress/one_byte_reads").set("ns_per_op", ns).set("reads_per_op", syscalls);
+}
+
+WT_BENCH("ingress/batched_reads") {
+    auto [ns, syscalls] = streamIngress(r.iters(2000000), 4096);
+    r.add("ingress/batched_reads").set("ns_per_op", ns).set("reads_per_op", syscalls);
+}
+
+/* ---------------- cross-thread command hand-off ---------------- */
+
+WT_BENCH("handoff/queue_throughput") {
+    const uint64_t n = r.iters(2000000);
+    util::BoundedQueue<StepperCommand> q(1024, util::OverflowPolicy::Reject);
+    std::atomic<bool> running{true};
+    uint64_t received = 0;
+
+    std::thread consumer([&] {
+        StepperCommand cmd;
+        while (received < n && q.popWait(cmd, running)) ++received;
+    });
+
+    uint64_t t0 = bench::nowNs();
+    for (uint64_t i = 0; i < n; ++i) {
+        StepperCommand cmd{StepperCommand::Kind::MoveBy, int32_t(i)};
+        while (!q.push(cmd)) std::this_thread::yield();
+    }
+    consumer.join();
+    uint64_t elapsed = bench::nowNs() - t0;
+
+    r.add("handoff/queue_throughput")
+        .set("ns_per_op", double(elapsed) / double(n))
+        .set("rejected_pushes", double(q.stats().rejected));
+}
+
+namespace {
+
+// One command in flight at a time; gapNs > 0 lets the consumer park between commands.
+void queueLatency(bench::Reporter& r, const char* name, uint64_t n, uint64_t gapNs) {
+    util::BoundedQueue<StepperCommand> q(16, util::OverflowPolicy::DropOldest);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> acked{0};
+    util::LatencyHistogram latency;
+
+    std::thread consumer([&] {
+        StepperCommand cmd;
+        while (q.popWait(cmd, running)) {
+            latency.record(util::monotonicNs() - cmd.enqueuedNs);
+            acked.fetch_add(1, std::memory_order_release);
+        }
+    });
+
+    // Bounded by time as well: on a single core every hand-off costs a reschedule.
+    const uint64_t deadline = bench::nowNs() + (r.options().quick ? 500000000ull : 3000000000ull);
+    for (uint64_t i = 0; i < n && bench::nowNs() < deadline; ++i) {
+        if (gapNs) std::this_thread::sleep_for(std::chrono::nanoseconds(gapNs));
+        StepperCommand cmd{StepperCommand::Kind::MoveBy, 1};
+        cmd.enqueuedNs = util::monotonicNs();
+        q.push(cmd);
+        // Yield rather than spin so this also works on a single core.
+        while (acked.load(std::memory_order_acquire) <= i) std::this_thread::yield();
+    }
+    running = false;
+    q.wakeAll();
+    consumer.join();
+
+    r.add(name).latency("handoff", latency);
+}
+
+} // namespace
+
+WT_BENCH("handoff/queue_latency_spinning") {
+    queueLatency(r, "handoff/queue_latency_spinning", r.iters(200000), 0);
+}
+
+WT_BENCH("handoff/queue_latency_parked") {
+    queueLatency(r, "handoff/queue_latency_parked", r.iters(5000), 200000);
+}
+
+/* ---------------- stepper phase emission ---------------- */
+
+WT_BENCH("stepper/phase_write") {
+    // One bulk write per step against the four single-line writes it
+    // replaced (one line handle per coil, as the old setupGPIO requested).
+    static constexpr uint8_t kMasks[] = {0b0011, 0b0110, 0b1100, 0b1001};
+    const unsigned int offsets[StepperController::kCoils] = {105, 106, 41, 43};
+    const uint64_t n = r.iters(10000000);
+    hal::SimLines lines("bench", 1024);
+    lines.open(offsets, StepperController::kCoils, "bench");
+    double ns = bench::timeLoop(n, [&](uint64_t i) { lines.write(kMasks[i & 3]); });
+    lines.close();
+
+    std::vector<std::unique_ptr<hal::SimLines>> perLine;
+    for (unsigned int offset : offsets) {
+        perLine.push_back(std::make_unique<hal::SimLines>("bench", 1024));
+        perLine.back()->open(&offset, 1, "bench");
+    }
+    double perLineNs = bench::timeLoop(n, [&](uint64_t i) {
+        for (size_t c = 0; c < perLine.size(); ++c) perLine[c]->write((kMasks[i & 3] >> c) & 1u);
+    });
+    for (auto& l : perLine) l->close();
+
+    r.add("stepper/phase_write")
+        .set("ns_per_op", ns)
+        .set("per_line_ns_per_op", perLineNs)
+        .set("steps_per_sec_ceiling", 1e9 / ns)
+        .set("per_line_steps_per_sec_ceiling", 1e9 / perLineNs);
+}
+
+namespace {
+
+struct StepperRun {
+    double stepsPerSec = 0;
+    uint64_t gpioWrites = 0;
+    uint64_t firstStepNs = 0;
+    uint64_t lastStepNs = 0;
+    util::LatencyHistogram timingError;
+};
+
+// Wakeup lateness of a bare absolute clock_nanosleep loop, until stop is set:
+// what the host's timer delivers with no controller involved.
+void timerLateness(uint64_t periodNs, const std::atomic<bool>& stop, util::LatencyHistogram& out) {
+    uint64_t deadline = util::monotonicNs();
+    while (!stop.load(std::memory_order_relaxed)) {
+        deadline += periodNs;
+        timespec ts{time_t(deadline / 1000000000ull), long(deadline % 1000000000ull)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+        uint64_t now = util::monotonicNs();
+        out.record(now > deadline ? now - deadline : 0);
+        if (now > deadline + periodNs) deadline = now;  // re-anchor, as StepScheduler does
+    }
+}
+
+void timerBaseline(uint64_t periodNs, std::chrono::milliseconds duration, util::LatencyHistogram& out) {
+    std::atomic<bool> stop{false};
+    std::thread sampler([&] { timerLateness(periodNs, stop, out); });
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    sampler.join();
+}
+
+// Host timer lateness to hold a controller run against. With a spare CPU it
+// is sampled alongside the run. On one CPU a sampler would steal the core
+// from the controller, so it is sampled for `duration` beforehand instead
+// and bounds use its max rather than its p99.
+class HostTimer {
+public:
+    HostTimer(uint64_t periodNs, std::chrono::milliseconds duration)
+        : alongside_(std::thread::hardware_concurrency() > 1) {
+        if (alongside_) {
+            sampler_ = std::thread([this, periodNs] { timerLateness(periodNs, stop_, hist_); });
+        } else {
+            timerBaseline(periodNs, duration, hist_);
+        }
+    }
+    ~HostTimer() { finish(); }
+
+    void finish() {
+        stop_ = true;
+        if (sampler_.joinable()) sampler_.join();
+    }
+
+    bool alongside() const { return alongside_; }
+    uint64_t meanNs() const { return hist_.mean(); }
+    uint64_t boundNs() const { return alongside_ ? hist_.percentile(99) : hist_.max(); }
+
+private:
+    const bool alongside_;
+    std::atomic<bool> stop_{false};
+    util::LatencyHistogram hist_;
+    std::thread sampler_;
+};
+
+// Run a MoveTo of `steps` through a live controller on the simulated lines.
+void moveStepper(const StepperTiming& timing, int32_t steps, DriveMode mode, StepperRun& run) {
+    std::vector<unsigned int> pins = {105, 106, 41, 43};
+    StepperController stepper(pins, "bench", timing, mode);
+    stepper.start();
+
+    uint64_t t0 = util::monotonicNs();
+    stepper.pushCommand({StepperCommand::Kind::MoveTo, steps});
+    while (stepper.position() != steps) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    uint64_t elapsed = util::monotonicNs() - t0;
+
+    const hal::TransitionLog& log = stepper.io().log();
+    run.gpioWrites = log.size();
+    if (log.size()) {
+        run.firstStepNs = log[0].tNs;
+        run.lastStepNs = log[log.size() - 1].tNs;
+    }
+    stepper.stop();
+    run.stepsPerSec = double(steps) * 1e9 / double(elapsed);
+    run.timingError.mergeFrom(stepper.stepTimingError());
+}
+
+void runStepper(bench::Reporter& r, const char* name, const StepperTiming& timing, int32_t steps) {
+    StepperRun run;
+    moveStepper(timing, steps, DriveMode::Full, run);
+    r.add(name)
+        .set("steps", steps)
+        .set("steps_per_sec", run.stepsPerSec)
+        .set("gpio_writes", double(run.gpioWrites))
+        .latency("timing_error", run.timingError);
+}
+
+// Highest commanded rate (no ramp) a drive mode still meets: at least 95%
+// of the rate achieved and p99 wakeup lateness under one wakeup period
+// beyond the host timer's bound, so the scheduler is not re-anchoring
+// (dropping) steps. Micro-stepping wakes kSlots times per step, so it runs
+// out first. Every mode must at least meet the default profile's peak.
+// On one CPU a single stall of the core can sink a short run at any rate,
+// so a rate gets a few attempts there before it counts as missed.
+void driveModeRate(bench::Reporter& r, DriveMode mode, const HostTimer& host) {
+    static constexpr double kRates[] = {500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000};
+    const double seconds = r.options().quick ? 0.03 : 0.2;
+    const size_t slots = mode == DriveMode::Micro ? drive::Policy<DriveMode::Micro>::kSlots : 1;
+    const int attempts = host.alongside() ? 1 : 3;
+
+    double lastP99 = 0;
+    auto meets = [&](double rate) {
+        StepperTiming timing;
+        timing.profile = {rate, rate, 0.0};
+        const double wakeNs = 1e9 / rate / double(slots);
+        for (int a = 0; a < attempts; ++a) {
+            StepperRun run;
+            moveStepper(timing, int32_t(std::max(100.0, rate * seconds)), mode, run);
+            const double p99 = double(run.timingError.percentile(99));
+            if (run.stepsPerSec >= 0.95 * rate && p99 <= wakeNs + double(host.boundNs())) {
+                lastP99 = p99;
+                return true;
+            }
+        }
+        return false;
+    };
+    const bool coversDefault = meets(MotionProfile{}.maxStepsPerSec);
+    double reliable = 0;
+    double p99AtReliable = 0;
+    for (double rate : kRates) {
+        if (!meets(rate)) break;
+        reliable = rate;
+        p99AtReliable = lastP99;
+    }
+
+    StepperTiming unbounded;
+    unbounded.profile = {1e6, 1e6, 0.0};
+    // Few enough steps that every micro-step slot fits the simulator's log.
+    const int32_t steps = int32_t(r.iters(5000));
+    StepperRun flat;
+    moveStepper(unbounded, steps, mode, flat);
+
+    r.add(std::string("stepper/drive_") + name(mode))
+        .set("max_reliable_steps_per_sec", reliable)
+        .set("timing_error_p99_ns_at_max", p99AtReliable)
+        .set("host_timer_bound_ns", double(host.boundNs()))
+        .set("unpaced_steps_per_sec", flat.stepsPerSec)
+        .set("gpio_writes_per_step", double(flat.gpioWrites) / double(steps))
+        .check("covers_default_profile", coversDefault);
+}
+
+} // namespace
+
+WT_BENCH("stepper/max_step_rate") {
+    // No ramp and a 1 µs interval: the loop runs as fast as it can emit.
+    StepperTiming timing;
+    timing.profile = {1e6, 1e6, 0.0};
+    runStepper(r, "stepper/max_step_rate", timing, int32_t(r.iters(50000)));
+}
+
+WT_BENCH("stepper/drive_modes") {
+    HostTimer host(1000000, std::chrono::milliseconds(r.options().quick ? 100 : 500));
+    for (DriveMode mode : {DriveMode::Wave, DriveMode::Full, DriveMode::Half, DriveMode::Micro}) {
+        driveModeRate(r, mode, host);
+    }
+}
+
+WT_BENCH("stepper/schedule_default_profile") {
+    // The achieved schedule against the ramp's plan, on the simulated lines.
+    // Every step must be emitted. Deadlines are absolute, so the move only
+    // drifts where a late wakeup re-anchors the grid: it may not exceed
+    // kDrift of its planned length plus the host's mean lateness per step.
+    // p99 lateness is held to kSlackNs over the host timer (see HostTimer),
+    // so a noisy host does not fail the run but delay the scheduler adds does.
+    constexpr double kDrift = 0.02;
+    constexpr uint64_t kSlackNs = 300000;
+    const StepperTiming timing{};
+    const int32_t steps = int32_t(r.iters(600));
+
+    TrapezoidRamp plan(timing.profile);
+    uint64_t plannedNs = 0;
+    for (int32_t k = 1; k < steps; ++k) plannedNs += plan.nextIntervalNs(steps - k);
+
+    HostTimer host(1000000, std::chrono::milliseconds(plannedNs / 1000000 + 1));
+    StepperRun run;
+    moveStepper(timing, steps, DriveMode::Full, run);
+    host.finish();
+
+    const double actualNs = double(run.lastStepNs - run.firstStepNs);
+    const double driftNs = std::fabs(actualNs - double(plannedNs));
+    const double driftBoundNs = kDrift * double(plannedNs) + double(steps) * double(host.meanNs()) +
+                                double(host.boundNs());
+    const uint64_t p99 = run.timingError.percentile(99);
+    r.add("stepper/schedule_default_profile")
+        .set("steps", steps)
+        .set("steps_per_sec", run.stepsPerSec)
+        .set("gpio_writes", double(run.gpioWrites))
+        .latency("timing_error", run.timingError)
+        .set("host_sampled_alongside", host.alongside() ? 1.0 : 0.0)
+        .set("host_timer_bound_ns", double(host.boundNs()))
+        .set("host_timer_mean_ns", double(host.meanNs()))
+        .set("planned_ms", double(plannedNs) / 1e6)
+        .set("drift_fraction", driftNs / double(plannedNs))
+        .set("drift_bound_fraction", driftBoundNs / double(plannedNs))
+        .check("all_steps", run.gpioWrites == uint64_t(steps))
+        .check("drift", driftNs <= driftBoundNs)
+        .check("timing_error_p99", p99 <= host.boundNs() + kSlackNs);
+}
+
+namespace {
+
+// Jog, then 30 ms into the move MoveTo 20 steps on (!reverse) or back
+// (reverse) from where the motor is, for `rounds`. Each command is given
+// time to take effect before the next, so none is merged into a later
+// one. Returns the controller's reaction histogram: time from each command
+// to the first step toward its target.
+void retargetRounds(uint64_t rounds, bool reverse, util::LatencyHistogram& out) {
+    std::vector<unsigned int> pins = {105, 106, 41, 43};
+    StepperController stepper(pins, "bench", StepperTiming{});
+    auto reacted = [&](uint64_t n) {
+        const uint64_t deadline = util::monotonicNs() + 1000000000ull;
+        while (stepper.reactionLatency().count() < n && util::monotonicNs() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    };
+    stepper.start();
+    for (uint64_t i = 0; i < rounds; ++i) {
+        const int32_t dir = reverse && (i & 1) ? -1 : 1;
+        stepper.pushCommand({StepperCommand::Kind::Jog, dir});
+        reacted(2 * i + 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        const int32_t by = reverse ? -dir * 20 : 20;
+        stepper.pushCommand({StepperCommand::Kind::MoveTo, int32_t(stepper.position()) + by});
+        reacted(2 * i + 2);
+    }
+    stepper.stop();
+    out.mergeFrom(stepper.reactionLatency());
+}
+
+} // namespace
+
+WT_BENCH("stepper/reaction_latency") {
+    // Reaction is the time to the first step toward a new target. A
+    // retarget the motor is already heading for must be acted on within one
+    // step: p99 at most the longest interval of the profile (its start
+    // rate) over the host timer bound. A reversal first has to brake, so
+    // it may also take the ramp from full speed down to the start rate.
+    const MotionProfile profile{};
+    const uint64_t rounds = r.iters(40);
+    const uint64_t stepNs = uint64_t(1e9 / profile.startStepsPerSec);
+    const uint64_t brakeNs = uint64_t((profile.maxStepsPerSec - profile.startStepsPerSec) /
+                                      profile.accelStepsPerSec2 * 1e9);
+
+    HostTimer host(1000000, std::chrono::milliseconds(rounds * 60));
+    util::LatencyHistogram sameWay, reversal;
+    retargetRounds(rounds, false, sameWay);
+    retargetRounds(rounds, true, reversal);
+    host.finish();
+
+    const uint64_t sameWayBoundNs = stepNs + host.boundNs();
+    const uint64_t reversalBoundNs = brakeNs + stepNs + host.boundNs();
+    r.add("stepper/reaction_latency")
+        .latency("same_way", sameWay)
+        .latency("reversal", reversal)
+        .set("host_timer_bound_ns", double(host.boundNs()))
+        .set("same_way_bound_ns", double(sameWayBoundNs))
+        .set("reversal_bound_ns", double(reversalBoundNs))
+        .check("all_commands", sameWay.count() == 2 * rounds && reversal.count() == 2 * rounds)
+        .check("same_way_p99", sameWay.percentile(99) <= sameWayBoundNs)
+        .check("reversal_p99", reversal.percentile(99) <= reversalBoundNs);
+}
+
+/* ---------------- servo duty writes ---------------- */
+
+WT_BENCH("servo/duty_write_tmpfs") {
+    // A fake sysfs tree on tmpfs, already "exported" so open() does not wait.
+    namespace fs = std::filesystem;
+    fs::path chip = fs::path(r.options().tmpDir) / ("wt-bench-pwm-" + std::to_string(getpid())) / "pwmchip0";
+    fs::create_directories(chip / "pwm0");
+    for (const char* attr : {"period", "duty_cycle", "enable"}) std::ofstream(chip / "pwm0" / attr) << "0";
+
+    const uint64_t n = r.iters(500000);
+    uint64_t errors = 0;
+    double ns = 0;
+    uint64_t allocs = 0;
+    {
+        hal::SysfsPwm pwm(chip.string(), 0);
+        pwm.open(20000000, 2500000);
+        uint64_t a0 = bench::allocations();
+        ns = bench::timeLoop(n, [&](uint64_t i) { errors += pwm.setDuty(500000 + uint32_t(i % 2000000)) < 0; });
+        allocs = bench::allocations() - a0;
+    }
+    fs::remove_all(chip.parent_path());
+
+    r.add("servo/duty_write_tmpfs")
+        .set("ns_per_op", ns)
+        .set("writes_per_sec", 1e9 / ns)
+        .set("allocs_per_op", double(allocs) / double(n))
+        .set("errors", double(errors));
+}
+
+WT_BENCH("servo/duty_write_sim") {
+    const uint64_t n = r.iters(10000000);
+    hal::SimPwm pwm("bench", 0, 1024);
+    pwm.open(20000000, 2500000);
+    double ns = bench::timeLoop(n, [&](uint64_t i) { pwm.setDuty(500000 + uint32_t(i & 0xFFFFF)); });
+    pwm.close();
+    r.add("servo/duty_write_sim").set("ns_per_op", ns);
+}
+
+WT_BENCH("servo/one_write_per_period") {
+    // Several targets per 20 ms period must collapse into one duty write per tick.
+    constexpr uint64_t kPeriodNs = 20000000;
+    constexpr int kPerPeriod = 5;
+    const uint64_t periods = r.iters(50);
+
+    ServoController servo("bench", 0);
+    servo.start();
+    const size_t before = servo.pwm().log().size();
+    uint64_t t0 = util::monotonicNs();
+    for (uint64_t p = 0; p < periods; ++p) {
+        for (int k = 0; k < kPerPeriod; ++k) {
+            servo.pushAngle(int32_t(60000 + ((p * kPerPeriod + k) % 7) * 10000));
+            std::this_thread::sleep_for(std::chrono::nanoseconds(kPeriodNs / kPerPeriod));
+        }
+    }
+    servo.stop();
+    uint64_t elapsed = util::monotonicNs() - t0;
+    const uint64_t writes = servo.pwm().log().size() - before;
+
+    r.add("servo/one_write_per_period")
+        .set("commands", double(periods * kPerPeriod))
+        .set("duty_writes", double(writes))
+        .set("ticks", double(servo.ticks()))
+        .check("writes_within_ticks", writes <= servo.ticks())
+        .check("at_most_one_write_per_period", writes <= elapsed / kPeriodNs + 1);
+}
+
+WT_BENCH("servo/trajectory_limits") {
+    // Polled on exact deadlines: move 180° → 90°, retarget to the current
+    // angle at full speed, then just ahead of it while braking. The angle
+    // read back from the duty must never exceed maxVel or maxAccel.
+    const ServoMotion motion;
+    constexpr double kDt = 0.02;
+    ServoController servo("bench", 0, motion);
+    servo.startPolled();
+    auto angle = [&] { return double(servo.pwm().duty() - 500000) / 2000000.0 * 180.0; };
+
+    std::vector<double> x{angle()};
+    double target = 90.0;
+    servo.pushAngle(90000);
+    uint64_t next = servo.poll(util::monotonicNs());
+    size_t ticks = 0;
+    for (; next != 0 && ticks < 1000; ++ticks) {
+        next = servo.poll(next);
+        x.push_back(angle());
+        if (ticks == 12 || ticks == 15) {
+            int32_t milliDeg = int32_t(std::lround((x.back() - (ticks == 15 ? 2.0 : 0.0)) * 1000.0));
+            servo.pushAngle(milliDeg);
+            target = milliDeg / 1000.0;
+        }
+    }
+    servo.stop();
+    x.push_back(x.back());  // at rest it stays put
+
+    double maxVel = 0.0;
+    double maxAccel = 0.0;
+    double prevV = 0.0;
+    for (size_t i = 1; i < x.size(); ++i) {
+        double v = (x[i] - x[i - 1]) / kDt;
+        maxVel = std::max(maxVel, std::fabs(v));
+        maxAccel = std::max(maxAccel, std::fabs(v - prevV) / kDt);
+        prevV = v;
+    }
+
+    r.add("servo/trajectory_limits")
+        .set("ticks", double(ticks))
+        .set("max_vel_deg_per_sec", maxVel)
+        .set("max_accel_deg_per_sec2", maxAccel)
+        .check("reaches_rest", next == 0)
+        .check("ends_on_target", std::fabs(x.back() - target) < 0.01)
+        .check("vel_within_limit", maxVel <= motion.maxVelDegPerSec * 1.01)
+        .check("accel_within_limit", maxAccel <= motion.maxAccelDegPerSec2 * 1.01);
+}
+
+/* ---------------- instrumentation overhead ---------------- */
+
+WT_BENCH("metrics/record") {
+    const uint64_t n = r.iters(10000000);
+    auto& m = metrics::registry();
+    double ns = bench::timeLoop(n, [&](uint64_t i) { m.record(metrics::Stage::Enqueue, i & 0xFFFF); });
+    m.reset();
+    r.add("metrics/record").set("ns_per_op", ns);
+}
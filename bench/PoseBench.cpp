@@ -0,0 +1,129 @@
+#include "Bench.hpp"
+#include "pose/KeypointClassifier.hpp"
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+/*
+ * Keypoint classification throughput in frames/sec: the vector kernel
+ * alone, a scalar acos-per-joint reference of the same computation, and
+ * the full classifier at batch sizes 1 and 16. The input is a synthetic
+ * arm curl with jitter and occasional low-confidence keypoints.
+ */
+
+namespace {
+
+constexpr size_t kFrames = 4096;
+
+std::vector<uint8_t> curlFrames() {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> jitter(0.0f, 0.004f);
+    std::uniform_real_distribution<float> conf(0.2f, 1.0f);
+
+    std::vector<uint8_t> out(kFrames * pose::kFrameBytes);
+    for (size_t f = 0; f < kFrames; ++f) {
+        float kp[pose::kFrameFloats];
+        for (size_t k = 0; k < pose::kKeypoints; ++k) {
+            // A loose standing skeleton; the forearms are overwritten below.
+            kp[3 * k] = 0.45f + 0.1f * float(k % 2) + jitter(rng);
+            kp[3 * k + 1] = 0.1f + 0.05f * float(k) + jitter(rng);
+            kp[3 * k + 2] = conf(rng);
+        }
+        const float elbow = float(M_PI) * (0.3f + 0.35f * (1.0f + std::sin(float(f) * 0.05f)));
+        for (int side = 0; side < 2; ++side) {
+            const float* e = &kp[3 * (7 + side)];
+            kp[3 * (9 + side)] = e[0] + 0.15f * std::sin(elbow) + jitter(rng);
+            kp[3 * (9 + side) + 1] = e[1] - 0.15f * std::cos(elbow) + jitter(rng);
+        }
+        std::memcpy(&out[f * pose::kFrameBytes], kp, pose::kFrameBytes);
+    }
+    return out;
+}
+
+// What the inference side did per frame: one acos per joint, in degrees.
+float scalarAngles(const uint8_t* frame, float minConfidence, float* deg) {
+    static constexpr uint8_t kA[] = {5, 6, 11, 12, 5, 6, 11, 12};
+    static constexpr uint8_t kB[] = {7, 8, 5, 6, 11, 12, 13, 14};
+    static constexpr uint8_t kC[] = {9, 10, 7, 8, 13, 14, 15, 16};
+    float kp[pose::kFrameFloats];
+    std::memcpy(kp, frame, pose::kFrameBytes);
+    float sum = 0.0f;
+    for (size_t l = 0; l < pose::kJoints; ++l) {
+        const float* a = &kp[3 * kA[l]];
+        const float* b = &kp[3 * kB[l]];
+        const float* c = &kp[3 * kC[l]];
+        if (a[2] < minConfidence || b[2] < minConfidence || c[2] < minConfidence) {
+            deg[l] = -1.0f;
+            continue;
+        }
+        const float ux = a[0] - b[0], uy = a[1] - b[1], vx = c[0] - b[0], vy = c[1] - b[1];
+        const float cosv = (ux * vx + uy * vy) / std::sqrt((ux * ux + uy * uy) * (vx * vx + vy * vy));
+        deg[l] = std::acos(std::fmax(-1.0f, std::fmin(1.0f, cosv))) * 180.0f / float(M_PI);
+        sum += deg[l];
+    }
+    return sum;
+}
+
+bench::Result& report(bench::Reporter& r, const char* name, double nsPerFrame, uint64_t allocs,
+                      uint64_t frames) {
+    return r.add(name)
+        .set("ns_per_frame", nsPerFrame)
+        .set("frames_per_sec", 1e9 / nsPerFrame)
+        .set("allocs_per_frame", double(allocs) / double(frames));
+}
+
+void classify(bench::Reporter& r, const char* name, size_t batch) {
+    const std::vector<uint8_t> frames = curlFrames();
+    const uint64_t passes = r.iters(200);
+    pose::KeypointClassifier classifier;
+    std::vector<proto::Command> out(batch * pose::KeypointClassifier::kMaxCommandsPerFrame);
+
+    uint64_t a0 = bench::allocations();
+    uint64_t commands = 0;
+    double ns = bench::timeLoop(passes, [&](uint64_t) {
+        for (size_t f = 0; f < kFrames; f += batch) {
+            commands += classifier.classify(&frames[f * pose::kFrameBytes], batch, out.data());
+        }
+    });
+    uint64_t allocs = bench::allocations() - a0;
+    bench::doNotOptimize(commands);
+    report(r, name, ns / double(kFrames), allocs, passes * kFrames)
+        .set("low_confidence_frames", double(classifier.lowConfidence()) / double(passes));
+}
+
+} // namespace
+
+WT_BENCH("pose/measure_vector") {
+    const std::vector<uint8_t> frames = curlFrames();
+    const uint64_t passes = r.iters(500);
+    std::vector<pose::JointSample> samples(pose::KeypointClassifier::kBatch);
+    double ns = bench::timeLoop(passes, [&](uint64_t) {
+        for (size_t f = 0; f < kFrames; f += samples.size()) {
+            pose::KeypointClassifier::measure(&frames[f * pose::kFrameBytes], samples.size(), 0.3f,
+                                              samples.data());
+            bench::doNotOptimize(samples[0].valid);
+        }
+    });
+    report(r, "pose/measure_vector", ns / double(kFrames), 0, passes * kFrames);
+}
+
+WT_BENCH("pose/measure_scalar_acos") {
+    const std::vector<uint8_t> frames = curlFrames();
+    const uint64_t passes = r.iters(500);
+    float deg[pose::kJoints];
+    double ns = bench::timeLoop(passes, [&](uint64_t) {
+        float sum = 0.0f;
+        for (size_t f = 0; f < kFrames; ++f) sum += scalarAngles(&frames[f * pose::kFrameBytes], 0.3f, deg);
+        bench::doNotOptimize(sum);
+    });
+    report(r, "pose/measure_scalar_acos", ns / double(kFrames), 0, passes * kFrames);
+}
+
+WT_BENCH("pose/classify_batch1") {
+    classify(r, "pose/classify_batch1", 1);
+}
+
+WT_BENCH("pose/classify_batch16") {
+    classify(r, "pose/classify_batch16", 16);
+}
@@ -0,0 +1,78 @@
+#include "Bench.hpp"
+#include "app/App.hpp"
+#include "app/Replay.hpp"
+#include "comm/CommandLog.hpp"
+#include "util/Metrics.hpp"
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+/*
+ * Max-speed replay of a command log through App::inject(): the throughput
+ * regression test. Pass a captured session with --replay-log; otherwise a
+ * synthetic 500 Hz pose stream is recorded first.
+ */
+
+namespace {
+
+std::string syntheticLog(const bench::Reporter& r) {
+    std::string path = r.options().tmpDir + "/wt-bench-replay-" + std::to_string(getpid()) + ".wtl";
+    const uint64_t n = r.iters(20000);
+    cmdlog::Writer w(path, n);
+    w.open();
+    for (uint64_t i = 0; i < n; ++i) {
+        proto::Command cmd;
+        bool jog = i % 10 == 9;
+        cmd.op = jog ? proto::Op::StepperJog : proto::Op::ServoPose;
+        cmd.arg = jog ? ((i / 10) & 1 ? 1 : -1) : int32_t(2 + i % 3);
+        cmd.seq = uint32_t(i + 1);
+        cmd.rxNs = 1000000000ull + i * 2000000ull;
+        cmd.source = proto::Source::TcpFramed;
+        w.append(cmd);
+    }
+    w.close();
+    return path;
+}
+
+void replayMax(bench::Reporter& r, const char* name, ExecMode mode) {
+    std::string path = r.options().replayLog.empty() ? syntheticLog(r) : r.options().replayLog;
+    cmdlog::Reader log(path);
+    log.open();
+
+    AppConfig cfg;
+    cfg.port = 0;
+    cfg.statsSocketPath.clear();
+    cfg.execMode = mode;
+    metrics::registry().reset();
+
+    App app(cfg);
+    app.init();
+    app.start();
+    std::atomic<bool> cancel{false};
+    ReplayResult res = replayLog(log, app, 0.0, cancel);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto& m = metrics::registry();
+    metrics::StageSummary deq = m.summary(metrics::Stage::Dequeue);
+    r.add(name)
+        .set("commands", double(res.commands))
+        .set("commands_per_sec", double(res.commands) * 1e9 / double(res.elapsedNs))
+        .set("ns_per_op", double(res.elapsedNs) / double(res.commands ? res.commands : 1))
+        .set("dispatched", double(m.counter(metrics::Counter::Commands)))
+        .set("dequeued", double(deq.count))
+        .set("dequeue_p99_ns", double(deq.p99));
+    app.stop();
+
+    log.close();
+    if (r.options().replayLog.empty()) unlink(path.c_str());
+}
+
+} // namespace
+
+WT_BENCH("replay/max_speed") {
+    replayMax(r, "replay/max_speed", ExecMode::Threaded);
+}
+
+WT_BENCH("replay/max_speed_reactor") {
+    replayMax(r, "replay/max_speed_reactor", ExecMode::Reactor);
+}
@@ -0,0 +1,359 @@
+#include "Bench.hpp"
+#include "comm/TelemetryUploader.hpp"
+#include "util/Clock.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifdef WT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/*
+ * TelemetryUploader against an in-process stand-in collector on loopback:
+ * what push() costs the ingress thread, end-to-end throughput with the
+ * uploader thread's CPU per record and its memory ceiling, and a collector
+ * outage that fills the capped spill directory and then drains it, and a
+ * spill directory left over the cap by a previous run.
+ */
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/** Minimal HTTP/1.1 collector: counts the NDJSON records in each POST body. */
+class StandInServer {
+public:
+    StandInServer() {
+        fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd_, 16) < 0 ||
+            getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+            close(fd_);
+            throw std::runtime_error("stand-in collector: cannot listen on loopback");
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread(&StandInServer::serve, this);
+    }
+
+    ~StandInServer() {
+        stop_ = true;
+        thread_.join();
+        close(fd_);
+    }
+
+    std::string url() const { return "http://127.0.0.1:" + std::to_string(port_) + "/ingest"; }
+    void setStatus(int status) { status_ = status; }
+    uint64_t records() const { return records_.load(); }
+    uint64_t requests() const { return requests_.load(); }
+
+private:
+    void serve() {
+        std::string req;
+        std::vector<uint8_t> inflated;
+        while (!stop_) {
+            pollfd p{fd_, POLLIN, 0};
+            if (poll(&p, 1, 20) != 1) continue;
+            int c = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (c < 0) continue;
+            req.clear();
+            size_t bodyAt = std::string::npos, contentLength = 0;
+            char buf[16384];
+            for (;;) {
+                ssize_t n = recv(c, buf, sizeof(buf), 0);
+                if (n <= 0) break;
+                req.append(buf, size_t(n));
+                if (bodyAt == std::string::npos) {
+                    size_t end = req.find("\r\n\r\n");
+                    if (end == std::string::npos) continue;
+                    bodyAt = end + 4;
+                    size_t cl = req.find("Content-Length: ");
+                    if (cl < end) contentLength = std::strtoull(req.c_str() + cl + 16, nullptr, 10);
+                }
+                if (req.size() >= bodyAt + contentLength) break;
+            }
+            ++requests_;
+            const int status = status_.load();
+            if (status == 200 && bodyAt != std::string::npos) {
+                const bool gzip = req.find("Content-Encoding: gzip") < bodyAt;
+                records_ += countRecords(reinterpret_cast<const uint8_t*>(req.data()) + bodyAt,
+                                         req.size() - bodyAt, gzip, inflated);
+            }
+            std::string resp = "HTTP/1.1 " + std::to_string(status) + (status == 200 ? " OK" : " Unavailable") +
+                               "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            (void)!send(c, resp.data(), resp.size(), MSG_NOSIGNAL);
+            close(c);
+        }
+    }
+
+    // Lines in the body, less the batch header line.
+    static uint64_t countRecords(const uint8_t* body, size_t len, bool gzip, std::vector<uint8_t>& inflated) {
+        if (gzip) {
+#ifdef WT_HAVE_ZLIB
+            z_stream zs{};
+            inflateInit2(&zs, 15 + 16);
+            inflated.resize(len * 16 + 4096);
+            zs.next_in = const_cast<Bytef*>(body);
+            zs.avail_in = uInt(len);
+            zs.next_out = inflated.data();
+            zs.avail_out = uInt(inflated.size());
+            while (inflate(&zs, Z_NO_FLUSH) == Z_OK && zs.avail_out == 0) {
+                size_t used = zs.total_out;
+                inflated.resize(inflated.size() * 2);
+                zs.next_out = inflated.data() + used;
+                zs.avail_out = uInt(inflated.size() - used);
+            }
+            len = zs.total_out;
+            inflateEnd(&zs);
+            body = inflated.data();
+#else
+            return 0;
+#endif
+        }
+        uint64_t lines = 0;
+        for (size_t i = 0; i < len; ++i) lines += body[i] == '\n';
+        return lines ? lines - 1 : 0;
+    }
+
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::atomic<int> status_{200};
+    std::atomic<uint64_t> records_{0};
+    std::atomic<uint64_t> requests_{0};
+    std::thread thread_;
+};
+
+telemetry::Record command(uint64_t i) {
+    telemetry::Record rec;
+    rec.tsNs = util::monotonicNs();
+    rec.kind = telemetry::Kind::Command;
+    rec.actuator = uint8_t(i & 1);
+    rec.command = {int32_t(i % 4000), uint8_t(1 + i % 6), 1, 200000 + i % 5000};
+    return rec;
+}
+
+// Push n records, yielding while the queue is full; returns how often it was.
+uint64_t pushAll(telemetry::Uploader& up, uint64_t n) {
+    uint64_t full = 0;
+    for (uint64_t i = 0; i < n; ++i) {
+        while (!up.push(command(i))) {
+            ++full;
+            std::this_thread::yield();
+        }
+    }
+    return full;
+}
+
+template <class Pred>
+bool waitFor(Pred&& done, uint64_t timeoutMs) {
+    const uint64_t deadline = util::monotonicNs() + timeoutMs * 1000000;
+    while (!done()) {
+        if (util::monotonicNs() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+telemetry::UploaderConfig benchConfig(const std::string& url) {
+    telemetry::UploaderConfig cfg;
+    cfg.url = url;
+    cfg.deviceId = "bench";
+    cfg.flushIntervalMs = 20;
+    cfg.sampleIntervalMs = 1000;
+    return cfg;
+}
+
+} // namespace
+
+WT_BENCH("telemetry/push") {
+    // The cost on an ingress thread. Pushes outrun the uploader here, so
+    // many land on a full queue; that path is measured as well.
+    StandInServer server;
+    telemetry::Uploader up(benchConfig(server.url()));
+    up.start();
+    const uint64_t n = r.iters(1000000);
+    std::vector<telemetry::Record> recs(1024);
+    for (size_t i = 0; i < recs.size(); ++i) recs[i] = command(i);
+
+    uint64_t a0 = bench::allocations();
+    double ns = bench::timeLoop(n, [&](uint64_t i) { up.push(recs[i & (recs.size() - 1)]); });
+    uint64_t allocs = bench::allocations() - a0;
+    up.stop();
+    const telemetry::UploaderStats s = up.stats();
+    r.add("telemetry/push")
+        .set("ns_per_push", ns)
+        .set("allocs_per_push", double(allocs) / double(n))
+        .set("queue_full_fraction", double(s.queueDropped) / double(n));
+}
+
+WT_BENCH("telemetry/throughput") {
+    StandInServer server;
+    telemetry::Uploader up(benchConfig(server.url()));
+    up.start();
+    const uint64_t n = r.iters(300000);
+
+    const uint64_t t0 = util::monotonicNs();
+    const uint64_t queueFull = pushAll(up, n);
+    const bool delivered = waitFor([&] { return server.records() >= n; }, 30000);
+    const double secs = double(util::monotonicNs() - t0) / 1e9;
+    up.stop();
+
+    const telemetry::UploaderStats s = up.stats();
+    r.add("telemetry/throughput")
+        .set("records_per_sec", double(server.records()) / secs)
+        .set("delivered_fraction", delivered ? 1.0 : double(server.records()) / double(n))
+        .set("batches", double(s.batches))
+        .set("wire_bytes_per_record", double(s.wireBytes) / double(s.sent ? s.sent : 1))
+        .set("compression_ratio", double(s.rawBytes) / double(s.wireBytes ? s.wireBytes : 1))
+        .set("uploader_cpu_ns_per_record", double(up.threadCpuNs()) / double(s.sent ? s.sent : 1))
+        .set("uploader_cpu_fraction", double(up.threadCpuNs()) / (secs * 1e9))
+        .set("memory_ceiling_bytes", double(up.memoryBytes()))
+        .set("producer_waits", double(queueFull));
+}
+
+WT_BENCH("telemetry/outage_spill") {
+    // Collector answers 503 while records keep coming: batches go to a
+    // 256 KiB spill directory (oldest evicted past the cap). Then it comes
+    // back and the backlog is resent.
+    StandInServer server;
+    server.setStatus(503);
+    const fs::path dir = fs::path(r.options().tmpDir) / ("wt-bench-spill-" + std::to_string(getpid()));
+    fs::remove_all(dir);
+
+    telemetry::UploaderConfig cfg = benchConfig(server.url());
+    cfg.spillDir = dir.string();
+    cfg.spillCapBytes = 256 * 1024;
+    cfg.backoffMinMs = 20;
+    cfg.backoffMaxMs = 200;
+    telemetry::Uploader up(cfg);
+    up.start();
+
+    const uint64_t n = r.iters(400000);
+    pushAll(up, n);
+    waitFor(
+        [&] {
+            telemetry::UploaderStats s = up.stats();
+            return s.spilled + s.lost >= n;
+        },
+        30000);
+    const telemetry::UploaderStats offline = up.stats();
+
+    const uint64_t t0 = util::monotonicNs();
+    server.setStatus(200);
+    const bool drained = waitFor([&] { return up.stats().spillBytes == 0; }, 30000);
+    const double recoverMs = double(util::monotonicNs() - t0) / 1e6;
+    up.stop();
+    fs::remove_all(dir);
+
+    const telemetry::UploaderStats s = up.stats();
+    r.add("telemetry/outage_spill")
+        .set("spill_cap_bytes", double(cfg.spillCapBytes))
+        .set("spill_bytes_at_peak", double(offline.spillBytes))
+        .set("spilled_records", double(offline.spilled))
+        .set("evicted_records", double(offline.spillEvicted))
+        .set("resent_records", double(server.records()))
+        .set("drained", drained ? 1.0 : 0.0)
+        .set("recover_ms", recoverMs)
+        .set("failed_posts", double(s.failures))
+        .set("memory_ceiling_bytes", double(up.memoryBytes()))
+        .check("spill_within_cap", offline.spillBytes <= cfg.spillCapBytes)
+        .check("drained", drained);
+}
+
+WT_BENCH("telemetry/stop_while_backing_off") {
+    // A collector that accepts connections but never answers: each POST
+    // waits out the receive timeout. Once the uploader is backing off,
+    // stop() must spill what is queued instead of trying again.
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        close(fd);
+        throw std::runtime_error("silent collector: cannot listen on loopback");
+    }
+    const fs::path dir = fs::path(r.options().tmpDir) / ("wt-bench-stop-" + std::to_string(getpid()));
+    fs::remove_all(dir);
+
+    telemetry::UploaderConfig cfg = benchConfig("http://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)) + "/ingest");
+    cfg.spillDir = dir.string();
+    cfg.timeoutMs = 300;
+    cfg.backoffMinMs = 60000;
+    telemetry::Uploader up(cfg);
+    up.start();
+    pushAll(up, 100);
+    const bool backingOff = waitFor([&] { return up.stats().failures >= 1; }, 5000);
+    pushAll(up, 100);
+
+    const uint64_t t0 = util::monotonicNs();
+    up.stop();
+    const double stopMs = double(util::monotonicNs() - t0) / 1e6;
+    close(fd);
+    fs::remove_all(dir);
+
+    const telemetry::UploaderStats s = up.stats();
+    r.add("telemetry/stop_while_backing_off")
+        .set("timeout_ms", double(cfg.timeoutMs))
+        .set("stop_ms", stopMs)
+        .set("spilled_records", double(s.spilled))
+        .check("backing_off", backingOff)
+        .check("stop_skips_post", stopMs < double(cfg.timeoutMs) / 2)
+        .check("all_spilled", s.spilled == 200 && s.failures == 1);
+}
+
+WT_BENCH("telemetry/spill_cap_on_start") {
+    // A previous run left more in the spill directory than the cap now
+    // allows: start() must evict the oldest files before anything is sent.
+    StandInServer server;
+    server.setStatus(503);
+    const fs::path dir = fs::path(r.options().tmpDir) / ("wt-bench-respill-" + std::to_string(getpid()));
+    fs::remove_all(dir);
+
+    telemetry::UploaderConfig cfg = benchConfig(server.url());
+    cfg.spillDir = dir.string();
+    cfg.spillCapBytes = 256 * 1024;
+    cfg.backoffMinMs = 20;
+    cfg.backoffMaxMs = 200;
+    const uint64_t n = r.iters(200000);
+    uint64_t leftBytes;
+    {
+        telemetry::Uploader up(cfg);
+        up.start();
+        pushAll(up, n);
+        up.stop();
+        leftBytes = up.stats().spillBytes;
+    }
+
+    cfg.spillCapBytes = leftBytes / 4;
+    telemetry::Uploader up(cfg);
+    up.start();
+    const telemetry::UploaderStats s = up.stats();
+    up.stop();
+    fs::remove_all(dir);
+
+    r.add("telemetry/spill_cap_on_start")
+        .set("left_bytes", double(leftBytes))
+        .set("spill_cap_bytes", double(cfg.spillCapBytes))
+        .set("spill_bytes_at_start", double(s.spillBytes))
+        .set("evicted_records", double(s.spillEvicted))
+        .check("spill_left", leftBytes > 0)
+        .check("spill_within_cap", s.spillBytes <= cfg.spillCapBytes)
+        .check("evicted", s.spillEvicted > 0);
+}
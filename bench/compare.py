@@ -0,0 +1,53 @@
+# compare.py - diff two workout-tracker-bench JSON reports
+#   python3 bench/compare.py base.json new.json [--threshold 10]
+import json, sys
+
+# Fields where smaller is better; anything else is reported without a verdict.
+_LOWER_IS_BETTER = ('_ns', 'ns_per_op', 'allocs_per_op', 'reads_per_op', 'dropped', 'errors')
+
+
+def load(path):
+    with open(path) as f:
+        doc = json.load(f)
+    return doc, {r['name']: r for r in doc['results']}
+
+
+def main(argv):
+    args = [a for a in argv[1:] if not a.startswith('--')]
+    threshold = 10.0
+    if '--threshold' in argv:
+        threshold = float(argv[argv.index('--threshold') + 1])
+        args.remove(argv[argv.index('--threshold') + 1])
+    if len(args) != 2:
+        print('usage: compare.py base.json new.json [--threshold PCT]', file=sys.stderr)
+        return 1
+
+    base_doc, base = load(args[0])
+    new_doc, new = load(args[1])
+    print(f"base: {base_doc.get('label') or args[0]}  new: {new_doc.get('label') or args[1]}")
+
+    regressions = 0
+    for name, result in new.items():
+        if name not in base:
+            print(f'{name}: new')
+            continue
+        for key, value in result.items():
+            if key == 'name' or key not in base[name]:
+                continue
+            old = base[name][key]
+            if not old:
+                continue
+            change = (value - old) / abs(old) * 100.0
+            if abs(change) < threshold:
+                continue
+            verdict = ''
+            if key.endswith(_LOWER_IS_BETTER):
+                worse = change > 0
+                verdict = '  REGRESSION' if worse else '  improved'
+                regressions += worse
+            print(f'{name}.{key}: {old:g} -> {value:g} ({change:+.1f}%){verdict}')
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,177 @@
+#pragma once
+#include "app/CommandProtocol.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Incremental workout analytics over the dispatched command stream.
+ *
+ * Servo poses for the tracked actuator id are positions of the tracked
+ * limb: pose 2 (180°) is the bottom of the range and pose 4 (145°) the
+ * top. Every position runs one step of a hysteresis state machine
+ * (bottom → concentric → top → eccentric → bottom) that counts reps and
+ * times their phases; stepper jogs on the same id are counted as lateral
+ * shifts. Other ids are ignored. Reps separated by more than a rest gap
+ * start a new set.
+ *
+ * onCommand() is O(1) and never allocates; all state is fixed-size. The
+ * analyzer is not thread-safe; see AnalyzerShard for feeding it from one
+ * thread while others read it.
+ */
+namespace analytics {
+
+struct AnalyzerConfig {
+    uint8_t actuator = 0;  // id whose servo is the tracked limb (proto::Command::actuator)
+    int32_t bottomMilliDeg = proto::poseMilliDegrees(2);
+    int32_t topMilliDeg = proto::poseMilliDegrees(4);
+    // Normalised position (0 = bottom, 1 = top) that must be crossed to
+    // leave the bottom and to reach the top. The gap is the hysteresis.
+    double leaveBottom = 0.25;
+    double reachTop = 0.75;
+    uint64_t setRestNs = 15000000000ull;  // idle time that ends a set
+};
+
+enum class Phase : uint8_t { Idle, Bottom, Concentric, Top, Eccentric };
+
+const char* name(Phase p);
+
+/** Running totals; averages are derived on read. */
+struct Totals {
+    uint32_t reps = 0;
+    uint32_t partials = 0;    // left the bottom but came back without reaching the top
+    uint64_t tutNs = 0;       // time under tension: leaving the bottom → back at the bottom
+    uint64_t concentricNs = 0;
+    uint64_t pauseNs = 0;     // held at the top
+    uint64_t eccentricNs = 0;
+    uint64_t romMilliDeg = 0; // summed range of motion, for the average
+    int32_t maxRomMilliDeg = 0;
+};
+
+struct SetSummary {
+    uint64_t startNs = 0;   // first rep left the bottom
+    uint64_t endNs = 0;     // last rep finished
+    Totals totals;
+};
+
+/** Fixed-size session record appended to the session log; see appendSessionRecord(). */
+struct SessionRecord {
+    static constexpr uint32_t kMagic = 0x57545331;  // "WTS1"
+    static constexpr uint16_t kVersion = 1;
+    static constexpr size_t kMaxSets = 16;
+
+    uint32_t magic = kMagic;
+    uint16_t version = kVersion;
+    uint16_t recordSize = 0;
+    uint64_t startRealNs = 0;     // CLOCK_REALTIME of the first command
+    uint64_t durationNs = 0;      // first → last command
+    uint32_t reps = 0;
+    uint32_t partials = 0;
+    uint32_t sets = 0;
+    uint32_t lateralShifts = 0;
+    uint64_t tutNs = 0;
+    uint32_t avgConcentricMs = 0;
+    uint32_t avgPauseMs = 0;
+    uint32_t avgEccentricMs = 0;
+    uint32_t avgRomMilliDeg = 0;
+    uint32_t maxRomMilliDeg = 0;
+    uint32_t reserved = 0;
+    std::array<uint16_t, kMaxSets> setReps{};  // reps of the first kMaxSets sets
+};
+static_assert(sizeof(SessionRecord) == 104, "record layout is part of the file format");
+
+class WorkoutAnalyzer {
+public:
+    static constexpr size_t kMaxSets = 32;  // kept individually; later sets only add to totals
+
+    explicit WorkoutAnalyzer(const AnalyzerConfig& cfg = {});
+
+    /** Feed one dispatched command, stamped with its rxNs. */
+    void onCommand(const proto::Command& cmd) noexcept;
+    /** Feed one limb position in millidegrees observed at tNs. */
+    void onPosition(int32_t milliDeg, uint64_t tNs) noexcept;
+
+    void reset();
+
+    const Totals& totals() const { return totals_; }
+    uint32_t sets() const { return sets_; }
+    uint32_t lateralShifts() const { return lateralShifts_; }
+    Phase phase() const { return phase_; }
+    const SetSummary* set(size_t i) const { return i < sets_ && i < kMaxSets ? &setList_[i] : nullptr; }
+
+    void appendJson(std::string& out) const;
+    void appendText(std::string& out, const char* indent = "") const;
+
+    /** Summarise the session; nowNs (CLOCK_MONOTONIC) places it on the wall clock. */
+    SessionRecord summarize(uint64_t nowNs) const;
+
+    /**
+     * Fold another analyzer's session into this one for reporting: totals
+     * add up, sets interleave by start time and the phase is that of the
+     * most recently fed analyzer. Each input should have seen whole rep
+     * streams; the result is for reading, not for feeding further.
+     */
+    void merge(const WorkoutAnalyzer& other);
+
+private:
+    double normalised(int32_t milliDeg) const;
+    void beginRep(uint64_t tNs);
+    void endRep(uint64_t tNs, bool complete);
+    Totals& currentSet();
+
+    AnalyzerConfig cfg_;
+    double span_;
+
+    Phase phase_ = Phase::Idle;
+    uint64_t lastBottomNs_ = 0;  // last sample still at the bottom
+    uint64_t repStartNs_ = 0;
+    uint64_t firstTopNs_ = 0;
+    uint64_t lastTopNs_ = 0;
+    int32_t repMinMilliDeg_ = 0;
+    int32_t repMaxMilliDeg_ = 0;
+    uint64_t lastRepEndNs_ = 0;
+
+    uint64_t firstEventNs_ = 0;
+    uint64_t lastEventNs_ = 0;
+    uint32_t lateralShifts_ = 0;
+    uint32_t sets_ = 0;
+    Totals totals_;
+    Totals overflowSet_;  // stands in for sets past kMaxSets
+    std::array<SetSummary, kMaxSets> setList_{};
+};
+
+/**
+ * A WorkoutAnalyzer fed by one thread and read from others. The writer
+ * never locks: it makes the sequence number odd around each update, and
+ * snapshot() copies the analyzer and retries if the number moved.
+ */
+class alignas(64) AnalyzerShard {
+public:
+    explicit AnalyzerShard(const AnalyzerConfig& cfg = {}) : analyzer_(cfg) {}
+
+    /** Owner thread only. */
+    void onCommand(const proto::Command& cmd) noexcept {
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        analyzer_.onCommand(cmd);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    /** Any thread: a consistent copy of the analyzer. */
+    void snapshot(WorkoutAnalyzer& out) const;
+
+private:
+    std::atomic<uint32_t> seq_{0};
+    WorkoutAnalyzer analyzer_;
+};
+
+/**
+ * Append one record to the session log at `path` (created if missing) with
+ * a single O_APPEND write, so records from concurrent runs never
+ * interleave. Throws std::runtime_error on failure.
+ */
+void appendSessionRecord(const std::string& path, const SessionRecord& rec);
+
+} // namespace analytics
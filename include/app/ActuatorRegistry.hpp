@@ -0,0 +1,107 @@
+#pragma once
+#include "app/CommandProtocol.hpp"
+#include "control/ServoController.hpp"
+#include "control/StepperController.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** One stepper or servo, as listed in config/app.yaml. */
+struct ActuatorSpec {
+    enum class Kind : uint8_t { Stepper, Servo };
+
+    Kind kind = Kind::Stepper;
+    std::string name;
+    uint8_t id = 0;  // routing address: proto::Command::actuator
+
+    // Stepper
+    std::string chip = "gpiochip0";
+    std::vector<unsigned int> lines;
+    StepperTiming timing;
+    DriveMode drive = DriveMode::Full;
+
+    // Servo
+    std::string pwmChip = "/sys/class/pwm/pwmchip0";
+    unsigned int channel = 0;
+    ServoMotion motion;
+};
+
+/** The original hard-wired layout: one stepper and one servo, both id 0. */
+std::vector<ActuatorSpec> defaultActuators();
+
+/**
+ * Parse the `actuators:` list of a YAML config (see config/app.yaml).
+ * Throws std::runtime_error on a malformed file, or if the binary was
+ * built without yaml-cpp.
+ */
+std::vector<ActuatorSpec> loadActuators(const std::string& path);
+
+/**
+ * Owns every configured controller and routes commands to them.
+ *
+ * Routing is a flat table with one row per actuator id and one column per
+ * opcode, filled in once at construction. Each cell holds the handler and
+ * its controller, so dispatch() is two clamped index computations and an
+ * indirect call regardless of how many actuators exist. A stepper and a
+ * servo may share an id since their opcodes do not overlap; that is how
+ * the legacy single-byte stream, which is always id 0, reaches both.
+ *
+ * start() and startPolled() bring every controller up at once, each on its
+ * own thread, since hardware setup dominates startup and no two controllers
+ * share any of it.
+ */
+class ActuatorRegistry {
+public:
+    template <class T>
+    struct Entry {
+        std::string name;
+        uint8_t id;
+        std::unique_ptr<T> controller;
+        uint64_t setupNs = 0;  // how long the last start took to bring the hardware up
+    };
+
+    // Throws std::invalid_argument if two actuators claim the same id and opcodes.
+    explicit ActuatorRegistry(const std::vector<ActuatorSpec>& specs);
+
+    // If any controller fails to start, the others are stopped again and
+    // the first failure is rethrown.
+    void start();
+    void startPolled();
+    void stop();
+
+    // Polled mode: run every controller due at nowNs. Returns the earliest
+    // next deadline, or 0 when all of them are idle.
+    uint64_t poll(uint64_t nowNs);
+
+    /** Route one command. False for an undecodable op. */
+    bool dispatch(const proto::Command& cmd) const {
+        // Out-of-range ids and ops clamp onto a trailing row/column of
+        // "not routed" and "unknown op" cells.
+        size_t row = std::min<size_t>(cmd.actuator, rows_ - 1);
+        size_t col = std::min<size_t>(size_t(cmd.op), kOpColumns - 1);
+        const Route& r = table_[row * kOpColumns + col];
+        return r.fn(r.target, cmd);
+    }
+
+    const std::vector<Entry<StepperController>>& steppers() const { return steppers_; }
+    const std::vector<Entry<ServoController>>& servos() const { return servos_; }
+
+private:
+    using Handler = bool (*)(void* target, const proto::Command& cmd);
+    struct Route {
+        Handler fn;
+        void* target;
+    };
+
+    void startAll(bool polled);
+
+    // Ops 0..Keypoints, plus one column for anything larger.
+    static constexpr size_t kOpColumns = size_t(proto::Op::Keypoints) + 2;
+
+    std::vector<Entry<StepperController>> steppers_;
+    std::vector<Entry<ServoController>> servos_;
+    size_t rows_ = 1;
+    std::vector<Route> table_;
+};
@@ -1,18 +1,39 @@
 #pragma once
-#include "control/StepperController.hpp"
-#include "control/ServoController.hpp"
+#include "analytics/WorkoutAnalyzer.hpp"
+#include "app/ActuatorRegistry.hpp"
+#include "app/CommandProtocol.hpp"
+#include "app/Config.hpp"
+#include "comm/CommandLog.hpp"
+#include "comm/ShmRing.hpp"
+#include "comm/TelemetryUploader.hpp"
+#include "pose/KeypointClassifier.hpp"
 #include <memory>
 #include <atomic>
 #include <thread>
 #include <chrono>
 #include <cstdint>
-#include <mutex>
-#include <condition_variable>
-#include <queue>
+#include <array>
+#include <string>
+#include <vector>
+
+/**
+ * Where startup time went, in ns. Actuator bring-up runs alongside the
+ * command log, telemetry and listener phases, so the phases do not add up
+ * to readyNs.
+ */
+struct StartupTiming {
+    uint64_t initNs = 0;        // init(): config, actuator table, ring/log/uploader objects
+    uint64_t commandLogNs = 0;
+    uint64_t telemetryNs = 0;
+    uint64_t listenNs = 0;
+    uint64_t actuatorsNs = 0;   // every controller's hardware setup, concurrently
+    uint64_t shmNs = 0;
+    uint64_t readyNs = 0;       // start() until listening with every actuator ready
+};
 
 class App {
 public:
-    App();
+    explicit App(AppConfig cfg = {});
     ~App();
 
     // lifecycle
@@ -21,23 +42,92 @@ public:
     void stop();   // signal cancellation and join
     void wait();   // block until stop() (used by main)
 
+    // Dispatch a command from outside the socket/shm paths (replay), from
+    // one thread at a time. rxNs is restamped; the command is logged as
+    // Source::Replay.
+    bool inject(proto::Command cmd);
+
+    // Filled in by init() and start().
+    const StartupTiming& startupTiming() const { return startup_; }
+
 private:
+    static constexpr size_t kRecvBufSize = 4096;
+    static constexpr int kMaxEvents = 64;
+
+    enum class WireMode : uint8_t { Unknown, Legacy, Binary };
+
+    // Last accepted sequence number of one framed source.
+    struct SeqState {
+        bool have = false;
+        uint32_t last = 0;
+    };
+
+    // Per-client state; the receive buffer is reused for every read.
+    struct Connection {
+        int fd = -1;
+        WireMode mode = WireMode::Unknown;
+        SeqState seq;
+        size_t len = 0;
+        std::array<uint8_t, kRecvBufSize> buf;
+    };
+
     void loopThreadFunc();
+    void shmThreadFunc();
+    bool openServer();
+    bool openStatsSocket();
+    void serveStats();
+    std::string statsJson() const;
+    void acceptClients();
+    void readClient(Connection& conn);
+    void closeClient(int fd);
+    bool parseCommands(Connection& conn, uint64_t rxNs);
+    bool acceptFrame(SeqState& seq, const proto::FrameView& frame, uint64_t rxNs) const;
+    void dispatchFrame(const proto::FrameView& frame, uint64_t rxNs, proto::Source source);
+    void classifyKeypoints(const proto::FrameView& frame, uint64_t rxNs, proto::Source source);
+    bool dispatchCommand(const proto::Command& cmd);
+    bool openTimer();
+    void pollControllers();
+    void pokeReactor();
+    void printStats() const;
+    void sampleTelemetry(telemetry::Uploader& up) const;
+    analytics::WorkoutAnalyzer workout() const;
+    void abortStart();
+
+    AppConfig cfg_;
+    SeqState shm_seq_;
+    uint64_t started_ns_ = 0;
+    StartupTiming startup_;
 
     std::atomic<bool> running_{false};
     std::atomic<bool> stop_requested_{false};
     std::thread loop_thread_;
+    std::thread shm_thread_;
+    std::unique_ptr<shm::RingReader> shm_ring_;
+    std::unique_ptr<cmdlog::Writer> cmd_log_;
+    std::unique_ptr<telemetry::Uploader> telemetry_;
+
+    // One analyzer per ingress path (socket loop, shm ring, replay), each
+    // fed lock-free by its own thread; workout() merges them on read.
+    enum AnalyticsShard : size_t { kSocketShard, kShmShard, kReplayShard, kAnalyticsShards };
+    std::array<analytics::AnalyzerShard, kAnalyticsShards> analytics_;
 
-    // very simple event queue for prototype
-    mutable std::mutex q_mtx_;
-    std::condition_variable q_cv_;
+    // Socket loop only: keypoint frames never arrive through the shm ring.
+    pose::KeypointClassifier keypoints_;
 
-    std::unique_ptr<StepperController> stepper_;
-    std::unique_ptr<ServoController> servo_;
+    std::unique_ptr<ActuatorRegistry> actuators_;
 
-    int port_ = 5005;
     int server_fd_ = -1;
-    int client_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;   // eventfd used by stop() to break epoll_wait
+    int stats_fd_ = -1;  // Unix listener for the stats endpoint
+
+    // Reactor mode only: one timer for the earliest controller deadline and
+    // the deadline it is armed for.
+    int timer_fd_ = -1;
+    uint64_t timer_armed_ns_ = 0;
+
+    // Indexed by fd so lookups on the hot path are a single load.
+    std::vector<std::unique_ptr<Connection>> conns_;
 
     void closeServer();
-};
\ No newline at end of file
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
+
+/**
+ * Wire protocol between the pose inference process and App.
+ *
+ * A connection starts in legacy mode (one ASCII byte per command, decoded as
+ * `byte - '0'`) unless its first byte is kNegotiateBinary, in which case the
+ * rest of the stream is a sequence of fixed-header frames:
+ *
+ *   offset  size  field
+ *        0     1  version (kVersion)
+ *        1     1  op (proto::Op)
+ *        2     1  actuator id
+ *        3     1  flags (reserved, 0)
+ *        4     4  arg (int32)
+ *        8     4  sequence number (uint32, wraps)
+ *       12     2  payload length in bytes following the header
+ *       14     2  reserved
+ *       16     8  sender timestamp, CLOCK_MONOTONIC ns
+ *
+ * All fields are little-endian, as are the keypoint float32s; FrameView and
+ * writeHeader() convert, which costs nothing on little-endian hosts. Frames
+ * are read in place from the receive buffer through FrameView; nothing is
+ * copied or allocated per frame.
+ *
+ * Only Op::Keypoints carries a payload: a batch of frames of 17 (x, y,
+ * confidence) float32 triples, classified into servo/stepper commands in
+ * App. A batch must fit the receive buffer (19 frames), and keypoints are
+ * accepted on the socket only, since shared-memory slots hold a header.
+ */
+namespace proto {
+
+constexpr uint8_t kNegotiateBinary = 0xB1;
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 24;
+
+enum class Op : uint8_t {
+    None       = 0,
+    StepperJog    = 1,   // arg > 0 clockwise, arg < 0 counter-clockwise
+    ServoPose     = 2,   // arg is a pose code: 2 lowest, 3 middle, 4 highest
+    StepperMoveTo = 3,   // arg is an absolute position in steps
+    StepperMoveBy = 4,   // arg is an offset in steps from the current target
+    StepperStop   = 5,   // arg ignored
+    ServoAngle    = 6,   // arg is the target angle in millidegrees (0..180000)
+    Keypoints     = 7,   // payload is one or more raw pose frames (pose/KeypointClassifier.hpp)
+};
+
+// Legacy single-byte codes (`byte - '0'`): 'R' → 34, 'L' → 28.
+constexpr int kLegacyStepCW  = 'R' - '0';
+constexpr int kLegacyStepCCW = 'L' - '0';
+
+/** Servo angle in millidegrees for a legacy pose code, or -1 for other codes. */
+constexpr int32_t poseMilliDegrees(int poseCode) {
+    switch (poseCode) {
+        case 2: return 180000;  // lowest
+        case 3: return 162500;  // middle
+        case 4: return 145000;  // highest
+        default: return -1;
+    }
+}
+
+/** Where a command entered App; recorded in the command log. */
+enum class Source : uint8_t {
+    TcpLegacy = 0,
+    TcpFramed = 1,
+    Shm       = 2,
+    Replay    = 3,
+};
+
+/**
+ * Decoded command handed to the dispatcher. Legacy bytes and frames both
+ * end up here; legacy commands have seq 0 and sentNs 0.
+ */
+struct Command {
+    Op op = Op::None;
+    uint8_t actuator = 0;
+    int32_t arg = 0;
+    uint32_t seq = 0;
+    uint64_t sentNs = 0;
+    uint64_t rxNs = 0;
+    Source source = Source::TcpLegacy;
+};
+
+/** Non-owning view of one frame header inside a receive buffer. */
+class FrameView {
+public:
+    explicit FrameView(const uint8_t* p) : p_(p) {}
+
+    uint8_t version() const { return p_[0]; }
+    Op op() const { return static_cast<Op>(p_[1]); }
+    uint8_t actuator() const { return p_[2]; }
+    uint8_t flags() const { return p_[3]; }
+    int32_t arg() const { return int32_t(le32toh(load<uint32_t>(4))); }
+    uint32_t seq() const { return le32toh(load<uint32_t>(8)); }
+    uint16_t payloadLen() const { return le16toh(load<uint16_t>(12)); }
+    uint64_t sentNs() const { return le64toh(load<uint64_t>(16)); }
+    const uint8_t* payload() const { return p_ + kHeaderSize; }
+    size_t size() const { return kHeaderSize + payloadLen(); }
+
+private:
+    // memcpy of a scalar compiles to a single (unaligned) load on x86/ARM64.
+    template <class T>
+    T load(size_t off) const {
+        T v;
+        std::memcpy(&v, p_ + off, sizeof(T));
+        return v;
+    }
+
+    const uint8_t* p_;
+};
+
+/**
+ * Encode a header at out[0, kHeaderSize). Used by in-process producers
+ * (shared-memory ring writer, benchmarks) that speak the same format.
+ */
+inline void writeHeader(uint8_t* out, Op op, uint8_t actuator, int32_t arg, uint32_t seq,
+                        uint64_t sentNs, uint16_t payloadLen = 0) {
+    const uint16_t reserved = 0;
+    const uint32_t argLe = htole32(uint32_t(arg));
+    const uint32_t seqLe = htole32(seq);
+    const uint16_t lenLe = htole16(payloadLen);
+    const uint64_t sentLe = htole64(sentNs);
+    out[0] = kVersion;
+    out[1] = static_cast<uint8_t>(op);
+    out[2] = actuator;
+    out[3] = 0;
+    std::memcpy(out + 4, &argLe, sizeof(argLe));
+    std::memcpy(out + 8, &seqLe, sizeof(seqLe));
+    std::memcpy(out + 12, &lenLe, sizeof(lenLe));
+    std::memcpy(out + 14, &reserved, sizeof(reserved));
+    std::memcpy(out + 16, &sentLe, sizeof(sentLe));
+}
+
+/** Map a legacy single-byte command to a Command. Returns false if unknown. */
+inline bool decodeLegacy(char byte, Command& out) {
+    int code = byte - '0';
+    switch (code) {
+        case kLegacyStepCW:
+            out.op = Op::StepperJog;
+            out.arg = 1;
+            return true;
+        case kLegacyStepCCW:
+            out.op = Op::StepperJog;
+            out.arg = -1;
+            return true;
+        case 2:
+        case 3:
+        case 4:
+            out.op = Op::ServoPose;
+            out.arg = code;
+            return true;
+        default:
+            return false;
+    }
+}
+
+struct ParseResult {
+    size_t used = 0;      // bytes consumed (whole frames only)
+    bool ok = true;       // false on a malformed frame; the stream cannot be resynced
+};
+
+/**
+ * Walk every complete frame in [data, data + len) and call onFrame(FrameView)
+ * for each. A trailing partial frame is left unconsumed.
+ */
+template <class F>
+ParseResult parseFrames(const uint8_t* data, size_t len, F&& onFrame) {
+    ParseResult r;
+    while (len - r.used >= kHeaderSize) {
+        FrameView frame(data + r.used);
+        if (frame.version() != kVersion) {
+            r.ok = false;
+            return r;
+        }
+        size_t n = frame.size();
+        if (len - r.used < n) break;
+        onFrame(frame);
+        r.used += n;
+    }
+    return r;
+}
+
+} // namespace proto
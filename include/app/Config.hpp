@@ -0,0 +1,64 @@
+#pragma once
+#include "analytics/WorkoutAnalyzer.hpp"
+#include "comm/TelemetryUploader.hpp"
+#include "pose/KeypointClassifier.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * How App schedules its work.
+ *   Threaded: the command loop, the stepper and the servo each own a thread
+ *             and hand commands over through queues.
+ *   Reactor:  one thread multiplexes the sockets and a single timerfd,
+ *             armed for the earliest controller deadline, with epoll and
+ *             advances the controllers as non-blocking state machines.
+ *             Fewer context switches.
+ */
+enum class ExecMode : uint8_t { Threaded, Reactor };
+
+/**
+ * Runtime settings for App. Defaults match the original hard-coded values.
+ */
+struct AppConfig {
+    int port = 5005;
+
+    // Framed commands whose sender timestamp is older than this on arrival
+    // are dropped instead of moving the actuators. 0 disables the check.
+    uint32_t maxFrameAgeMs = 250;
+
+    // Shared-memory ring for a co-located inference process (see
+    // comm/ShmRing.hpp). Empty path disables it; the socket stays available.
+    std::string shmRingPath;
+    uint32_t shmRingCapacity = 1024;
+
+    // Unix socket that answers every connection with a JSON stats snapshot.
+    // Empty disables it.
+    std::string statsSocketPath = "/tmp/workout-tracker.stats";
+
+    // Binary log of every dispatched command (comm/CommandLog.hpp), for
+    // replay. Empty disables it. 32 bytes per record, preallocated.
+    std::string commandLogPath;
+    uint64_t commandLogCapacity = uint64_t(1) << 18;
+
+    // Session summaries from the workout analytics (analytics/WorkoutAnalyzer.hpp)
+    // are appended here on stop(), 104 bytes each. Empty disables it.
+    std::string sessionLogPath;
+
+    // Rep counting thresholds, and which actuator id is the tracked limb.
+    analytics::AnalyzerConfig analytics;
+
+    // YAML file listing the steppers and servos (see config/app.yaml and
+    // app/ActuatorRegistry.hpp). Empty uses the built-in single-axis layout.
+    std::string actuatorConfigPath;
+
+    // Command, actuator and session telemetry POSTed to a collector (see
+    // comm/TelemetryUploader.hpp). An empty telemetry.url disables it.
+    telemetry::UploaderConfig telemetry;
+
+    // Raw keypoint frames (proto::Op::Keypoints) are classified with this.
+    pose::ClassifierConfig pose;
+
+    ExecMode execMode = ExecMode::Threaded;
+    int reactorCpu = -1;       // Reactor mode: >= 0 pins the thread to this CPU
+    int reactorPriority = 0;   // Reactor mode: > 0 requests SCHED_FIFO
+};
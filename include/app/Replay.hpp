@@ -0,0 +1,18 @@
+#pragma once
+#include "app/App.hpp"
+#include "comm/CommandLog.hpp"
+#include <atomic>
+#include <cstdint>
+
+struct ReplayResult {
+    uint64_t commands = 0;
+    uint64_t elapsedNs = 0;
+    uint64_t maxLagNs = 0;   // worst lateness against the scaled schedule
+};
+
+/**
+ * Feed a command log back through App::inject(), keeping the recorded
+ * spacing divided by `speed` (1 = real time, N = N times faster, 0 = as
+ * fast as possible). Returns early once `cancel` is set.
+ */
+ReplayResult replayLog(const cmdlog::Reader& log, App& app, double speed, const std::atomic<bool>& cancel);
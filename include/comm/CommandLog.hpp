@@ -0,0 +1,117 @@
+#pragma once
+#include "app/CommandProtocol.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Append-only binary log of every command App dispatches, for post-mortem
+ * inspection and replay (tools/replay.cpp, workout-tracker-bench).
+ *
+ * The file is preallocated and mapped once at open(); append() claims a
+ * slot with one atomic add and fills it in place, so recording costs no
+ * syscalls and is safe from the socket and shm threads at once. A slot is
+ * marked committed last, so a reader can skip one that a crash left
+ * half-written. When the log is full further commands are only counted.
+ */
+namespace cmdlog {
+
+constexpr uint32_t kMagic = 0x57544C31;  // "WTL1"
+constexpr uint32_t kLayoutVersion = 1;
+constexpr size_t kCacheLine = 64;
+
+struct Record {
+    uint64_t rxNs;       // CLOCK_MONOTONIC at ingress
+    uint64_t sentNs;     // sender timestamp, 0 if the source has none
+    int32_t arg;
+    uint32_t seq;
+    uint8_t op;          // proto::Op
+    uint8_t actuator;
+    uint8_t source;      // proto::Source
+    uint8_t committed;   // written last
+    uint32_t reserved;
+};
+static_assert(sizeof(Record) == 32, "record layout is part of the file format");
+
+struct LogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t capacity;      // records
+    uint64_t startMonoNs;   // CLOCK_MONOTONIC and CLOCK_REALTIME at open(),
+    uint64_t startRealNs;   // to put rxNs on a wall clock
+
+    alignas(kCacheLine) std::atomic<uint64_t> next;  // slots claimed, may exceed capacity
+    std::atomic<uint64_t> dropped;                   // appends after the log filled up
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "log needs lock-free 64-bit atomics");
+
+constexpr size_t kRecordsOffset = (sizeof(LogHeader) + kCacheLine - 1) / kCacheLine * kCacheLine;
+
+/** Recording side, owned by App. */
+class Writer {
+public:
+    explicit Writer(std::string path, uint64_t capacity = uint64_t(1) << 18);
+    ~Writer();
+
+    void open();   // create/truncate, preallocate and map; throws on failure
+    void close();  // unmap and trim the file to the records written
+
+    bool append(const proto::Command& cmd) noexcept;
+
+    uint64_t records() const;
+    uint64_t dropped() const;
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+    uint64_t capacity_;
+    int fd_ = -1;
+    LogHeader* hdr_ = nullptr;
+    Record* records_ = nullptr;
+    size_t mapSize_ = 0;
+};
+
+/** Read-only view of a finished (or live) log. */
+class Reader {
+public:
+    explicit Reader(std::string path);
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    void open();  // throws on a missing or malformed file
+    void close();
+
+    size_t size() const { return count_; }  // slots, including any never committed
+    const Record& operator[](size_t i) const { return records_[i]; }
+    const LogHeader& header() const { return *hdr_; }
+
+    /** Call onRecord(const Record&) for every committed record, in log order. */
+    template <class F>
+    size_t forEach(F&& onRecord) const {
+        size_t n = 0;
+        for (size_t i = 0; i < count_; ++i) {
+            if (!records_[i].committed) continue;
+            onRecord(records_[i]);
+            ++n;
+        }
+        return n;
+    }
+
+    static proto::Command toCommand(const Record& r);
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    const LogHeader* hdr_ = nullptr;
+    const Record* records_ = nullptr;
+    size_t count_ = 0;
+    size_t mapSize_ = 0;
+};
+
+} // namespace cmdlog
@@ -0,0 +1,109 @@
+#pragma once
+#include "app/CommandProtocol.hpp"
+#include "util/Metrics.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Single-producer/single-consumer command ring in a memory-mapped file
+ * (normally under /dev/shm), for a pose inference process running on the
+ * same board. Each slot holds one frame header in the wire format from
+ * CommandProtocol.hpp, so the consumer reuses the socket path's checks.
+ *
+ * The consumer (App) creates and sizes the file; producers attach to it
+ * through the C ABI in comm/shm_ring_writer.h. When the ring runs dry the
+ * consumer spins briefly, then parks on a futex in the mapping that the
+ * producer only wakes if the consumer has announced it is waiting.
+ */
+namespace shm {
+
+constexpr uint32_t kMagic = 0x57545231;  // "WTR1"
+constexpr uint32_t kLayoutVersion = 1;
+constexpr size_t kSlotSize = proto::kHeaderSize;
+constexpr size_t kCacheLine = 64;
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;   // slots, power of two
+    uint32_t slotSize;
+
+    alignas(kCacheLine) std::atomic<uint64_t> head;      // next slot to write (producer)
+    alignas(kCacheLine) std::atomic<uint64_t> tail;      // next slot to read (consumer)
+    alignas(kCacheLine) std::atomic<uint32_t> futexWord; // bumped on every wakeup
+    std::atomic<uint32_t> consumerWaiting;
+    std::atomic<uint64_t> producerDrops;                 // sends rejected on a full ring
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring needs lock-free 64-bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "ring needs lock-free 32-bit atomics");
+
+constexpr size_t kSlotsOffset = (sizeof(RingHeader) + kCacheLine - 1) / kCacheLine * kCacheLine;
+
+inline size_t mappingSize(uint32_t capacity) {
+    return kSlotsOffset + size_t(capacity) * kSlotSize;
+}
+
+inline uint8_t* slotAt(RingHeader* hdr, uint64_t index) {
+    return reinterpret_cast<uint8_t*>(hdr) + kSlotsOffset + (index & (hdr->capacity - 1)) * kSlotSize;
+}
+
+// Shared (not FUTEX_PRIVATE) futex ops: the word lives in a cross-process mapping.
+int futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs);
+int futexWake(std::atomic<uint32_t>* word);
+
+/** Consumer side of the ring. */
+class RingReader {
+public:
+    explicit RingReader(std::string path, uint32_t capacity = 1024);
+    ~RingReader();
+
+    void open();   // create or reset the ring file and map it; throws on failure
+    void close();
+
+    /**
+     * Hand every available frame to onFrame(FrameView); returns the number
+     * of slots consumed. A slot holds only a header, so frames with another
+     * protocol version or a payload are skipped and counted as Unknown.
+     */
+    template <class F>
+    size_t drain(F&& onFrame) {
+        uint64_t tail = hdr_->tail.load(std::memory_order_relaxed);
+        uint64_t head = hdr_->head.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i != head; ++i) {
+            proto::FrameView frame(slotAt(hdr_, i));
+            if (frame.version() != proto::kVersion || frame.payloadLen() != 0) {
+                metrics::registry().add(metrics::Counter::Unknown);
+                continue;
+            }
+            onFrame(frame);
+        }
+        if (head != tail) hdr_->tail.store(head, std::memory_order_release);
+        return size_t(head - tail);
+    }
+
+    /**
+     * Block until the producer publishes, wake() is called, or timeoutMs
+     * elapses. Spins for spinIters polls before parking on the futex.
+     * Returns at once if `cancel` is set; set it before calling wake() and
+     * the wakeup cannot be missed.
+     */
+    void waitForData(int spinIters, int timeoutMs, const std::atomic<bool>& cancel);
+    void wake();
+
+    uint64_t producerDrops() const;
+    const std::string& path() const { return path_; }
+
+private:
+    bool empty() const;
+
+    std::string path_;
+    uint32_t capacity_;
+    int fd_ = -1;
+    RingHeader* hdr_ = nullptr;
+    size_t mapSize_ = 0;
+};
+
+} // namespace shm
@@ -0,0 +1,220 @@
+#pragma once
+#include "util/BoundedQueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+/**
+ * Ships session and actuator telemetry to an HTTP collector.
+ *
+ * Producers push fixed-size Records into a bounded lock-free queue; a full
+ * queue drops the record and counts it, so the ingress and actuation
+ * threads never wait on the network. One uploader thread batches the
+ * queue as NDJSON (gzip-compressed when built with zlib), POSTs each batch
+ * and backs off exponentially while the collector is unreachable. The
+ * collector's address is resolved on the first POST and reused until a
+ * connect fails. Batches that cannot be sent go to a spill directory capped
+ * in bytes (oldest evicted before a write would exceed it) and are re-sent
+ * oldest first once a POST succeeds again. Memory is bounded by the queue,
+ * one batch and the compressor state.
+ *
+ * Only plain http:// is spoken; put a TLS-terminating proxy in front of a
+ * remote collector.
+ */
+namespace telemetry {
+
+enum class Kind : uint8_t { Command, Stepper, Servo, Session };
+
+struct CommandSample {
+    int32_t arg;
+    uint8_t op;      // proto::Op
+    uint8_t source;  // proto::Source
+    uint64_t ageNs;  // ingress minus sender timestamp, 0 if the source has none
+};
+
+struct StepperSample {
+    int64_t position;
+    uint64_t pushed;       // commands queued
+    uint64_t lost;         // overflowed, coalesced or rejected
+    uint64_t timingP99Ns;  // step timing error
+};
+
+struct ServoSample {
+    uint64_t dutyWrites;
+    uint64_t writeErrors;
+    uint64_t pushed;
+    uint64_t lost;
+};
+
+struct SessionSample {
+    uint32_t reps;
+    uint32_t partials;
+    uint32_t sets;
+    uint32_t lateralShifts;
+    uint64_t tutNs;
+    uint64_t durationNs;
+};
+
+struct Record {
+    uint64_t tsNs = 0;  // CLOCK_MONOTONIC; sent as wall-clock milliseconds
+    Kind kind = Kind::Command;
+    uint8_t actuator = 0;
+    union {
+        CommandSample command;
+        StepperSample stepper;
+        ServoSample servo;
+        SessionSample session;
+    };
+
+    Record() : stepper{} {}
+};
+static_assert(sizeof(Record) == 48, "keep queue slots small");
+
+struct UploaderConfig {
+    std::string url;       // http://host[:port]/path, IPv6 as [addr]; empty disables upload
+    std::string spillDir;  // empty: batches that cannot be sent are dropped
+    std::string deviceId;  // defaults to the host name
+    size_t queueCapacity = 4096;      // records, power of two
+    size_t maxBatchRecords = 1024;
+    uint32_t flushIntervalMs = 2000;  // send a partial batch after this long
+    uint32_t sampleIntervalMs = 1000; // how often the sampler runs
+    uint32_t timeoutMs = 2000;        // connect, and each send/receive
+    uint32_t backoffMinMs = 500;
+    uint32_t backoffMaxMs = 60000;
+    uint64_t spillCapBytes = uint64_t(8) << 20;
+    int compressLevel = 1;  // zlib level; speed matters more than ratio here
+};
+
+struct UploaderStats {
+    uint64_t queued = 0;          // records accepted by push()
+    uint64_t queueDropped = 0;    // records refused by a full queue
+    uint64_t sent = 0;            // records the collector acknowledged
+    uint64_t batches = 0;         // successful POSTs
+    uint64_t rawBytes = 0;        // NDJSON bytes acknowledged
+    uint64_t wireBytes = 0;       // request bodies acknowledged
+    uint64_t failures = 0;        // POST attempts that failed or were refused
+    uint64_t spilled = 0;         // records written to the spill directory
+    uint64_t spillEvicted = 0;    // spilled records deleted to stay under the cap
+    uint64_t lost = 0;            // records dropped with no spill directory, or rejected by a 4xx
+    uint64_t spillBytes = 0;      // current size of the spill directory
+};
+
+class Uploader {
+public:
+    // Runs on the uploader thread every sampleIntervalMs, to push() periodic samples.
+    using Sampler = std::function<void(Uploader&)>;
+
+    // Throws std::invalid_argument for a URL that is not http://host[:port]/path.
+    explicit Uploader(UploaderConfig cfg);
+    ~Uploader();
+
+    Uploader(const Uploader&) = delete;
+    Uploader& operator=(const Uploader&) = delete;
+
+    void setSampler(Sampler sampler) { sampler_ = std::move(sampler); }
+
+    // Creates the spill directory and picks up files left in it, evicting the
+    // oldest down to spillCapBytes. Throws on failure.
+    void start();
+    // Sends what is queued and joins the thread. One attempt, unless the
+    // collector is already being backed off from; what is not sent is spilled.
+    void stop();
+
+    /** Any thread. False if the queue was full and the record was dropped. */
+    bool push(const Record& rec) {
+        if (!running_.load(std::memory_order_relaxed)) return false;
+        return queue_.push(rec);
+    }
+
+    UploaderStats stats() const;
+    // Bytes currently allocated for the queue, batch buffers and compressor
+    // state. Buffers keep their capacity, so once warmed up this is the ceiling.
+    size_t memoryBytes() const;
+    // CPU time used by the uploader thread so far.
+    uint64_t threadCpuNs() const;
+    const std::string& url() const { return cfg_.url; }
+
+private:
+    struct Address {
+        sockaddr_storage addr;
+        socklen_t len;
+        int family;
+        int protocol;
+    };
+
+    struct SpillFile {
+        uint64_t seq;
+        uint64_t records;
+        uint64_t bytes;
+        bool gzip;
+    };
+
+    void run();
+    void shipQueued(uint64_t nowNs, bool force);
+    void encode(const Record* recs, size_t n);
+    bool compress();  // text_ → body_; false if body_ is plain NDJSON
+    void deliver(const std::vector<uint8_t>& body, bool gzip, uint64_t records, uint64_t rawBytes, uint64_t nowNs);
+    void drainSpill(uint64_t nowNs);
+    void failed(uint64_t nowNs, int status);
+    // HTTP status, or 0 if the collector could not be reached.
+    int post(const std::vector<uint8_t>& body, bool gzip);
+    bool resolve();
+    void noteBuffers();
+    void spill(const std::vector<uint8_t>& body, bool gzip, uint64_t records);
+    // Drops the oldest spill files until `incoming` more bytes fit under the cap.
+    void evictSpill(uint64_t incoming);
+    std::string spillPath(const SpillFile& f) const;
+    void scanSpill();
+
+    UploaderConfig cfg_;
+    std::string host_;
+    std::string port_;
+    std::string path_;
+    bool gzip_ = false;
+
+    util::BoundedQueue<Record> queue_;
+    Sampler sampler_;
+
+    // Uploader thread only.
+    std::vector<Record> batch_;
+    std::string text_;
+    std::vector<uint8_t> body_;
+    std::vector<uint8_t> spillBuf_;
+    std::vector<Address> addrs_;  // cached collector address; empty until resolved
+    std::deque<SpillFile> spillFiles_;
+    uint64_t nextSpillSeq_ = 0;
+    uint64_t batchSeq_ = 0;
+    uint64_t realOffsetNs_ = 0;  // CLOCK_REALTIME - CLOCK_MONOTONIC at start()
+    uint64_t backoffMs_ = 0;
+    uint64_t retryAtNs_ = 0;
+    void* zstream_ = nullptr;    // z_stream, kept between batches
+
+    std::atomic<bool> running_{false};
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> rawBytes_{0};
+    std::atomic<uint64_t> wireBytes_{0};
+    std::atomic<uint64_t> failures_{0};
+    std::atomic<uint64_t> spilled_{0};
+    std::atomic<uint64_t> spillEvicted_{0};
+    std::atomic<uint64_t> lost_{0};
+    std::atomic<uint64_t> spillBytes_{0};
+    std::atomic<size_t> bufferBytes_{0};
+    std::atomic<size_t> zlibBytes_{0};  // counted by the deflate allocator
+    std::atomic<uint64_t> cpuNs_{0};
+};
+
+} // namespace telemetry
@@ -0,0 +1,33 @@
+#ifndef WT_SHM_RING_WRITER_H
+#define WT_SHM_RING_WRITER_H
+
+/*
+ * C ABI producer for the shared-memory command ring (see comm/ShmRing.hpp).
+ * Built as libwt_shm_writer.so so the Python inference side can load it with
+ * ctypes (src/py_inference/shm_ring.py).
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct wt_shm_writer wt_shm_writer;
+
+/* Attach to a ring created by workout-tracker. Returns NULL (errno set) on failure. */
+wt_shm_writer* wt_shm_writer_open(const char* path);
+
+/*
+ * Publish one command. sent_ns of 0 stamps CLOCK_MONOTONIC now.
+ * Returns 0 on success, -1 if the ring is full (the command is dropped).
+ */
+int wt_shm_writer_send(wt_shm_writer* w, uint8_t op, uint8_t actuator, int32_t arg, uint64_t sent_ns);
+
+void wt_shm_writer_close(wt_shm_writer* w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WT_SHM_RING_WRITER_H */
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Coil drive sequences for a 4-coil unipolar stepper on a ULN2003, one bit
+ * per coil (IN1 = bit 0). Each mode is a policy with a constexpr phase
+ * table; StepperController instantiates its step loop once per policy so
+ * the table lookups and slot handling inline into straight-line code.
+ *
+ *   Wave   one coil at a time: 4 phases, least torque, least current.
+ *   Full   two adjacent coils: 4 phases, most torque (the original drive).
+ *   Half   alternating one and two coils: 8 phases, twice the resolution.
+ *   Micro  16 phases per electrical cycle. Plain GPIO cannot set a coil
+ *          current, so each phase is a pattern of kSlots masks spread over
+ *          the step interval; a coil is on for a share of the slots that
+ *          follows the cosine of its angle from the rotor position.
+ *
+ * Positions and targets are counted in the mode's own steps, so one Half
+ * step is half a Full step and one Micro step a quarter.
+ */
+enum class DriveMode : uint8_t { Wave, Full, Half, Micro };
+
+const char* name(DriveMode m);
+bool parseDriveMode(const char* s, DriveMode& out);
+
+namespace drive {
+
+constexpr size_t kCoils = 4;
+
+template <size_t Phases, size_t Slots>
+using Table = std::array<std::array<uint8_t, Slots>, Phases>;
+
+template <DriveMode M>
+struct Policy;
+
+template <>
+struct Policy<DriveMode::Wave> {
+    static constexpr size_t kPhases = 4;
+    static constexpr size_t kSlots = 1;
+    static constexpr Table<kPhases, kSlots> kTable = [] {
+        Table<kPhases, kSlots> t{};
+        for (size_t i = 0; i < kPhases; ++i) t[i][0] = uint8_t(1u << i);
+        return t;
+    }();
+};
+
+template <>
+struct Policy<DriveMode::Full> {
+    static constexpr size_t kPhases = 4;
+    static constexpr size_t kSlots = 1;
+    static constexpr Table<kPhases, kSlots> kTable = [] {
+        Table<kPhases, kSlots> t{};
+        for (size_t i = 0; i < kPhases; ++i) t[i][0] = uint8_t((1u << i) | (1u << ((i + 1) % kCoils)));
+        return t;
+    }();
+};
+
+template <>
+struct Policy<DriveMode::Half> {
+    static constexpr size_t kPhases = 8;
+    static constexpr size_t kSlots = 1;
+    static constexpr Table<kPhases, kSlots> kTable = [] {
+        Table<kPhases, kSlots> t{};
+        for (size_t j = 0; j < kPhases; ++j) {
+            size_t i = j / 2;
+            t[j][0] = uint8_t((1u << i) | (j % 2 ? 1u << ((i + 1) % kCoils) : 0u));
+        }
+        return t;
+    }();
+};
+
+template <>
+struct Policy<DriveMode::Micro> {
+    static constexpr size_t kPhases = 16;
+    static constexpr size_t kSlots = 8;
+    static constexpr Table<kPhases, kSlots> kTable = [] {
+        // round(8 * cos(k * 22.5°)) for k = 0..4: slots a coil is on at that offset.
+        constexpr uint8_t kCosSlots[] = {8, 7, 6, 3, 0};
+        Table<kPhases, kSlots> t{};
+        for (size_t p = 0; p < kPhases; ++p) {
+            for (size_t coil = 0; coil < kCoils; ++coil) {
+                // Offset of the rotor from this coil's axis, in 22.5° units.
+                size_t d = (p + kPhases - coil * kPhases / kCoils) % kPhases;
+                uint8_t on = d <= 4 ? kCosSlots[d] : d >= kPhases - 4 ? kCosSlots[kPhases - d] : 0;
+                for (size_t s = 0; s < on; ++s) t[p][s] |= uint8_t(1u << coil);
+            }
+        }
+        return t;
+    }();
+};
+
+static_assert(Policy<DriveMode::Wave>::kTable[3][0] == 0b1000, "unexpected wave table");
+static_assert(Policy<DriveMode::Full>::kTable[0][0] == 0b0011 && Policy<DriveMode::Full>::kTable[3][0] == 0b1001,
+              "unexpected full-step table");
+static_assert(Policy<DriveMode::Half>::kTable[1][0] == 0b0011 && Policy<DriveMode::Half>::kTable[7][0] == 0b1001,
+              "unexpected half-step table");
+// Micro phase 0 is coil 0 alone; phase 2 drives coils 0 and 1 equally (the full-step position).
+static_assert(Policy<DriveMode::Micro>::kTable[0][7] == 0b0001 && Policy<DriveMode::Micro>::kTable[2][5] == 0b0011 &&
+                  Policy<DriveMode::Micro>::kTable[2][6] == 0,
+              "unexpected micro-step table");
+
+} // namespace drive
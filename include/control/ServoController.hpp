@@ -1,49 +1,98 @@
 #pragma once
+#include "control/StepScheduler.hpp"
+#include "hal/Backend.hpp"
+#include "util/BoundedQueue.hpp"
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
+#include <cstdint>
 #include <string>
 #include <thread>
 
+/** Target angle plus the stamps used for latency accounting. */
+struct ServoSetpoint {
+    int32_t milliDegrees = 0;
+    uint64_t rxNs = 0;
+    uint64_t enqueuedNs = 0;
+};
+
+/** Angular limits for the servo trajectory, in degrees. */
+struct ServoMotion {
+    double maxVelDegPerSec = 300.0;
+    double maxAccelDegPerSec2 = 2000.0;
+};
+
 /**
- * Lightweight PWM-based servo controller using the sysfs PWM interface.
+ * Lightweight PWM-based servo controller on the PWM backend selected in
+ * hal/Backend.hpp (sysfs PWM, or the simulator).
+ *
+ * Commands set a target angle (0–180°). The worker ticks once per PWM
+ * period (20 ms) on a grid anchored at start(): each tick collapses every
+ * pending command into the latest target, advances a velocity/acceleration
+ * limited trajectory toward it and writes duty_cycle at most once. When the
+ * servo has reached its target the worker parks until the next command.
+ * startPolled() skips the worker; the owner calls poll() on its own timer.
  *
- * Commands are integers shared with the inference stream:
- *   2 → move toward minimum angle
- *   3 → move toward maximum angle
- * Additional integers are ignored for now.
+ * Legacy pose codes from the inference stream map to fixed angles:
+ *   2 → 180° (lowest), 3 → 162.5° (middle), 4 → 145° (highest)
  */
 class ServoController {
 public:
     ServoController(const std::string& chipPath = "/sys/class/pwm/pwmchip0",
-                    unsigned int channel = 0);
+                    unsigned int channel = 0,
+                    const ServoMotion& motion = {});
     ~ServoController();
 
     void start();
+    void startPolled();
     void stop();
 
-    void pushCommand(int cmd);
+    // Polled mode: tick if due at nowNs. Returns the next deadline, or 0 at rest.
+    uint64_t poll(uint64_t nowNs);
+
+    // rxNs is the ingress timestamp, when there is one.
+    void pushCommand(int poseCode, uint64_t rxNs = 0);  // legacy pose codes; others ignored
+    void pushAngle(int32_t milliDegrees, uint64_t rxNs = 0);
+
+    util::QueueStats queueStats() const { return queue_.stats(); }
+    uint64_t writeErrors() const { return writeErrors_.load(std::memory_order_relaxed); }
+    uint64_t dutyWrites() const { return dutyWrites_.load(std::memory_order_relaxed); }
+    uint64_t ticks() const { return ticks_.load(std::memory_order_relaxed); }
+    const util::LatencyHistogram& tickTimingError() const { return clock_.timingError(); }
+
+    const hal::PwmChannel& pwm() const { return pwm_; }
 
 private:
     void controlLoop();
+    bool atRest() const { return angle_ == target_ && velocity_ == 0.0; }
+    void tick();
+    void takeSetpoint(const ServoSetpoint& sp);
+    uint32_t dutyForAngle(double degrees) const;
     void setupPWM();
     void teardownPWM();
-    void writeFile(const std::string& path, const std::string& value);
 
-    const std::string chipPath_;
-    const unsigned int channel_;
-    std::string pwmPath_;
+    hal::PwmChannel pwm_;
+    ServoMotion motion_;
 
     const uint32_t periodNs_ = 20000000;      // 20 ms (50 Hz)
     const uint32_t minDutyNs_ = 500000;      // 0.5 ms pulse
     const uint32_t maxDutyNs_ = 2500000;      // 2.5 ms pulse
     uint32_t dutyNs_          = 2500000;      // start lowered
 
+    // Trajectory state, owned by the worker.
+    double angle_ = 180.0;
+    double velocity_ = 0.0;
+    double target_ = 180.0;
+    uint64_t anchorNs_ = 0;
+    StepScheduler clock_;
+    ServoSetpoint pending_;        // newest setpoint not yet written; enqueuedNs == 0 when none
+    uint64_t pendingDequeuedNs_ = 0;
+
     std::thread worker_;
     std::atomic<bool> running_{false};
+    std::atomic<uint64_t> writeErrors_{0};
+    std::atomic<uint64_t> dutyWrites_{0};
+    std::atomic<uint64_t> ticks_{0};
 
-    std::mutex qMutex_;
-    std::condition_variable qCv_;
-    std::queue<int> queue_;
+    // Only the newest target matters; anything older is coalesced away.
+    static constexpr size_t kQueueCapacity = 8;
+    util::BoundedQueue<ServoSetpoint> queue_{kQueueCapacity, util::OverflowPolicy::CoalesceLatest};
 };
@@ -0,0 +1,83 @@
+#pragma once
+#include "util/LatencyHistogram.hpp"
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Velocity limits for one stepper, in steps per second. Moves start at
+ * startStepsPerSec (below the motor's pull-in rate), accelerate at
+ * accelStepsPerSec2 up to maxStepsPerSec and decelerate symmetrically so
+ * they arrive at the target at the start rate again.
+ */
+struct MotionProfile {
+    double startStepsPerSec = 200.0;
+    double maxStepsPerSec = 333.3;    // the old fixed 3 ms step period
+    double accelStepsPerSec2 = 2000.0;
+};
+
+/** Thread placement for the step loop; the defaults leave the thread alone. */
+struct StepperTiming {
+    MotionProfile profile;
+    int rtPriority = 0;   // > 0 requests SCHED_FIFO at this priority
+    int cpu = -1;         // >= 0 pins the step thread to this CPU
+};
+
+/**
+ * Trapezoidal velocity ramp evaluated one step at a time. Each call yields
+ * the interval until the following step given how many steps remain, so
+ * the target may change between calls and the ramp follows it.
+ */
+class TrapezoidRamp {
+public:
+    explicit TrapezoidRamp(const MotionProfile& profile = {});
+
+    void reset();
+    uint64_t nextIntervalNs(int64_t stepsRemaining);
+    double velocity() const { return v_; }
+    // True when the motor may stop or reverse without a ramp.
+    bool atStartSpeed() const { return p_.accelStepsPerSec2 <= 0.0 || v_ <= p_.startStepsPerSec; }
+    const MotionProfile& profile() const { return p_; }
+
+private:
+    MotionProfile p_;
+    double v_;
+};
+
+/**
+ * Absolute-deadline step clock on CLOCK_MONOTONIC. Deadlines advance by the
+ * requested interval from the previous deadline, not from the wakeup, so
+ * wakeup latency does not accumulate into the step rate. The lateness of
+ * every wakeup is recorded in a histogram that can be read while running.
+ *
+ * The sleep is a futex wait with an absolute CLOCK_MONOTONIC timeout, so
+ * interrupt() from another thread ends it immediately on shutdown.
+ */
+class StepScheduler {
+public:
+    /** Apply SCHED_FIFO / CPU affinity to the calling thread; logs on failure. */
+    static void configureThread(const StepperTiming& timing, const char* name);
+
+    void begin();                       // first deadline is "now"
+    // First deadline is the next point on the grid anchorNs + k * periodNs.
+    void beginAligned(uint64_t anchorNs, uint64_t periodNs);
+    // Block until the current deadline; false if interrupt() cut it short.
+    bool sleepUntilDeadline();
+    // Wake the sleeper; later sleeps return false at once until rearm().
+    void interrupt();
+    void rearm() { interrupted_.store(0, std::memory_order_relaxed); }
+    // Account for a wakeup at nowNs when the caller waited on its own timer.
+    void wokeAt(uint64_t nowNs);
+    void advance(uint64_t intervalNs) {
+        deadlineNs_ += intervalNs;
+        intervalNs_ = intervalNs;
+    }
+    uint64_t deadlineNs() const { return deadlineNs_; }
+
+    const util::LatencyHistogram& timingError() const { return lateness_; }
+
+private:
+    uint64_t deadlineNs_ = 0;
+    uint64_t intervalNs_ = 0;
+    std::atomic<uint32_t> interrupted_{0};  // futex word
+    util::LatencyHistogram lateness_;
+};
@@ -1,49 +1,133 @@
 #pragma once
+#include "control/DriveMode.hpp"
+#include "control/StepScheduler.hpp"
+#include "hal/Backend.hpp"
+#include "util/BoundedQueue.hpp"
+#include "util/LatencyHistogram.hpp"
+#include <array>
 #include <thread>
 #include <atomic>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include <cstdint>
 #include <vector>
 #include <string>
-#include <gpiod.h>
 
 /**
- * StepperController drives a 4-wire stepper via a ULN2003 driver using libgpiod.
+ * Setpoint update for a stepper. Commands only move the target; the step
+ * loop picks them up between steps and retargets without finishing the
+ * previous move.
+ */
+struct StepperCommand {
+    enum class Kind : uint8_t {
+        Jog,     // value > 0 / < 0: target becomes position ± kJogSteps; 0 is ignored
+        MoveTo,  // value = absolute position in steps
+        MoveBy,  // value = offset from the current target
+        Stop,    // brake to a halt as soon as the ramp allows
+    };
+
+    Kind kind = Kind::Stop;
+    int32_t value = 0;
+    uint64_t rxNs = 0;        // ingress time, if the command came off the wire
+    uint64_t enqueuedNs = 0;  // stamped by pushCommand()
+};
+
+/**
+ * StepperController drives a 4-wire stepper via a ULN2003 driver through the
+ * GPIO backend selected in hal/Backend.hpp (libgpiod, or the simulator).
  *
- * cmd = 0 → rotate clockwise
- * cmd = 1 → rotate counter-clockwise
+ * The coil sequence is chosen per motor at construction (see
+ * control/DriveMode.hpp); the step loop is compiled once per mode.
+ *
+ * The motor follows an absolute position target. Each step the loop drains
+ * pending commands, recomputes the remaining distance and lets the ramp
+ * decide the next interval, so a new command takes effect on the next step.
+ *
+ * start() runs that loop on its own thread. startPolled() only claims the
+ * lines; the owner then calls poll() from its event loop and re-arms a timer
+ * for the returned deadline (see App's reactor mode).
  */
 class StepperController {
 public:
     StepperController(const std::vector<unsigned int>& gpioLines,
-                      const std::string& chipName = "gpiochip0");
+                      const std::string& chipName = "gpiochip0",
+                      const StepperTiming& timing = {},
+                      DriveMode mode = DriveMode::Full);
     ~StepperController();
 
+    static constexpr size_t kCoils = drive::kCoils;  // ULN2003 inputs IN1..IN4
+    static constexpr int32_t kJogSteps = 50;  // distance covered by one jog command
+
     void start();
+    void startPolled();
     void stop();
 
-    void pushCommand(int cmd);
+    void pushCommand(StepperCommand cmd);
+
+    // Polled mode: run whatever is due at nowNs. Returns the next deadline
+    // (CLOCK_MONOTONIC ns), or 0 when idle until the next command.
+    uint64_t poll(uint64_t nowNs);
+
+    int64_t position() const { return position_.load(std::memory_order_relaxed); }
+    int64_t target() const { return targetPublished_.load(std::memory_order_relaxed); }
+
+    util::QueueStats queueStats() const { return cmdQueue_.stats(); }
+    // Wakeup lateness of every step against its deadline, in ns.
+    const util::LatencyHistogram& stepTimingError() const { return scheduler_.timingError(); }
+    // Time from pushCommand() to the first step toward the new target, in ns.
+    // Braking steps still carrying the motor the old way do not count.
+    const util::LatencyHistogram& reactionLatency() const { return reaction_; }
+
+    const hal::GpioLines& io() const { return io_; }
+    DriveMode driveMode() const { return mode_; }
+    size_t slotsPerStep() const;  // GPIO writes per step: 1, or the micro-step PWM slots
 
 private:
     void controlLoop();
-    void stepCW(int steps);
-    void stepCCW(int steps);
+    void wake(const StepperCommand& cmd);
+    uint64_t onDeadline() { return (this->*onDeadline_)(); }
+    template <DriveMode M>
+    uint64_t onDeadlineFor();
+    void applyCommand(const StepperCommand& cmd);
+    template <DriveMode M>
+    void stepOnce(int direction);
+    void recordActuation();
+    void writePhase(uint8_t mask);
 
     void setupGPIO();
     void cleanupGPIO();
 
-    std::string chipName_;
     std::vector<unsigned int> lines_;
-    gpiod_chip* chip_ = nullptr;
-    std::vector<gpiod_line*> handles_;
+    hal::GpioLines io_;            // all coils, written with one call per step
+    unsigned int phase_ = 0;       // current index into the phase table
+    DriveMode mode_;
+    uint64_t (StepperController::*onDeadline_)();
+    size_t slot_ = 0;              // Micro: next PWM slot of the current step; 0 between steps
+    uint64_t slotNs_ = 0;
+
+    StepperTiming timing_;
+    TrapezoidRamp ramp_;
+    StepScheduler scheduler_;
+
+    // Motion state, owned by the step thread.
+    int64_t target_ = 0;
+    int direction_ = 0;            // -1, 0 (stopped), +1
+
+    // Stamps of the oldest command not yet acted on; enqueuedNs == 0 when none.
+    struct Pending {
+        uint64_t rxNs = 0;
+        uint64_t enqueuedNs = 0;
+        uint64_t dequeuedNs = 0;
+    } pending_;
+    uint64_t reactSinceNs_ = 0;  // enqueue stamp of the oldest command no step has moved toward yet
+
+    std::atomic<int64_t> position_{0};
+    std::atomic<int64_t> targetPublished_{0};
+    util::LatencyHistogram reaction_;
 
     std::thread controlThread_;
     std::atomic<bool> running_{false};
 
-    std::queue<int> cmdQueue_;
-    std::mutex qMutex_;
-    std::condition_variable qCv_;
-
-    static constexpr int stepsPerCommand_ = 50; // tweak as needed
+    // Commands are applied in order between steps, so the queue only fills
+    // if the sender floods faster than the step rate; then the oldest go.
+    static constexpr size_t kQueueCapacity = 16;
+    util::BoundedQueue<StepperCommand> cmdQueue_{kQueueCapacity, util::OverflowPolicy::DropOldest};
 };
@@ -0,0 +1,27 @@
+#pragma once
+
+/**
+ * Compile-time selection of the hardware backends. Controllers hold these
+ * aliases by value, so there is no virtual dispatch on the step/duty path.
+ * Configure with -DWORKOUT_TRACKER_SIM=ON to build against the simulator.
+ */
+#if defined(WT_HAL_SIM) && WT_HAL_SIM
+#include "hal/Sim.hpp"
+
+namespace hal {
+using GpioLines = SimLines;
+using PwmChannel = SimPwm;
+inline constexpr bool kSimulated = true;
+} // namespace hal
+
+#else
+#include "hal/GpiodLines.hpp"
+#include "hal/SysfsPwm.hpp"
+
+namespace hal {
+using GpioLines = GpiodLines;
+using PwmChannel = SysfsPwm;
+inline constexpr bool kSimulated = false;
+} // namespace hal
+
+#endif
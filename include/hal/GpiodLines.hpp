@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <gpiod.h>
+
+namespace hal {
+
+constexpr size_t kMaxLines = 8;
+
+/**
+ * A group of output lines on one gpiochip, requested as a single libgpiod
+ * bulk so every update is one set-values ioctl. Bit j of the mask passed to
+ * write() drives the j-th requested line.
+ */
+class GpiodLines final {
+public:
+    explicit GpiodLines(std::string chipName);
+    ~GpiodLines();
+
+    GpiodLines(const GpiodLines&) = delete;
+    GpiodLines& operator=(const GpiodLines&) = delete;
+
+    void open(const unsigned int* offsets, size_t count, const char* consumer);  // throws
+    void close();
+
+    int write(uint32_t mask) noexcept;
+
+    const std::string& name() const { return chipName_; }
+
+private:
+    std::string chipName_;
+    gpiod_chip* chip_ = nullptr;
+    gpiod_line_bulk bulk_{};
+    bool requested_ = false;
+};
+
+} // namespace hal
@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * Simulated GPIO and PWM backends. They mirror GpiodLines and SysfsPwm
+ * call-for-call, but instead of touching hardware they append a
+ * timestamped transition to a log preallocated at construction. The log
+ * never grows: once full, further transitions are counted as dropped.
+ * One thread writes (the controller); others may read entries [0, size()).
+ *
+ * Exported PWM channels are process-wide, like the kernel's: a SimPwm that
+ * is never closed leaves its channel configured for the next one on the same
+ * path, which is what a restart after a crash finds on real hardware.
+ */
+namespace hal {
+
+/** Delays the simulator adds to model slow bring-up; zero by default. */
+struct SimSetupLatency {
+    uint32_t linesOpenUs = 0;  // each SimLines::open (chip open and line request)
+    uint32_t pwmExportUs = 0;  // a SimPwm::open that has to export its channel
+    uint32_t pwmWriteUs = 0;   // each attribute SimPwm::open writes
+};
+
+void setSimSetupLatency(const SimSetupLatency& latency);
+
+struct Transition {
+    uint64_t tNs;    // CLOCK_MONOTONIC
+    uint32_t value;  // line mask or duty in ns
+};
+
+class TransitionLog {
+public:
+    static constexpr size_t kDefaultCapacity = size_t(1) << 16;
+
+    explicit TransitionLog(size_t capacity = kDefaultCapacity);
+
+    void record(uint32_t value) noexcept;
+    void clear() noexcept;
+
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    const Transition& operator[](size_t i) const { return entries_[i]; }
+
+private:
+    std::unique_ptr<Transition[]> entries_;
+    size_t capacity_;
+    std::atomic<size_t> size_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
+
+class SimLines final {
+public:
+    explicit SimLines(std::string chipName, size_t logCapacity = TransitionLog::kDefaultCapacity);
+
+    void open(const unsigned int* offsets, size_t count, const char* consumer);
+    void close();
+
+    int write(uint32_t mask) noexcept {
+        mask_ = mask;
+        log_.record(mask);
+        return 0;
+    }
+
+    const std::string& name() const { return chipName_; }
+    uint32_t mask() const { return mask_; }
+    const TransitionLog& log() const { return log_; }
+    TransitionLog& log() { return log_; }
+
+private:
+    std::string chipName_;
+    uint32_t mask_ = 0;
+    TransitionLog log_;
+};
+
+class SimPwm final {
+public:
+    SimPwm(std::string chipPath, unsigned int channel,
+           size_t logCapacity = TransitionLog::kDefaultCapacity);
+
+    void open(uint32_t periodNs, uint32_t dutyNs);
+    void close();
+
+    int setDuty(uint32_t dutyNs) noexcept {
+        dutyNs_ = dutyNs;
+        log_.record(dutyNs);
+        return 0;
+    }
+    int setPeriod(uint32_t periodNs) noexcept {
+        periodNs_ = periodNs;
+        return 0;
+    }
+    int setEnabled(bool on) noexcept {
+        enabled_ = on;
+        return 0;
+    }
+
+    bool isOpen() const { return open_; }
+    const std::string& path() const { return pwmPath_; }
+    unsigned setupWrites() const { return setupWrites_; }
+    uint32_t duty() const { return dutyNs_; }
+    uint32_t period() const { return periodNs_; }
+    bool enabled() const { return enabled_; }
+    const TransitionLog& log() const { return log_; }
+    TransitionLog& log() { return log_; }
+
+private:
+    std::string pwmPath_;
+    bool open_ = false;
+    unsigned setupWrites_ = 0;
+    bool enabled_ = false;
+    uint32_t periodNs_ = 0;
+    uint32_t dutyNs_ = 0;
+    TransitionLog log_;
+};
+
+} // namespace hal
@@ -0,0 +1,58 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace hal {
+
+/**
+ * One sysfs PWM channel (/sys/class/pwm/pwmchipN/pwmM).
+ *
+ * open() exports and configures the channel and keeps period, duty_cycle
+ * and enable open for the lifetime of the object. It reads the current
+ * state back first and writes only what differs, so re-opening a channel
+ * left configured (say, by a process that crashed) skips the export wait
+ * and every sysfs write. Updates are a single
+ * pwrite() of a stack-formatted decimal, with no allocation, and report
+ * failures as -errno instead of throwing, so they are safe on the servo's
+ * hot path. Setup and teardown may throw/allocate as before.
+ */
+class SysfsPwm final {
+public:
+    // Upper bound on waiting for the channel to appear after export.
+    static constexpr std::chrono::milliseconds kExportTimeout{1000};
+
+    SysfsPwm(std::string chipPath, unsigned int channel);
+    ~SysfsPwm();
+
+    SysfsPwm(const SysfsPwm&) = delete;
+    SysfsPwm& operator=(const SysfsPwm&) = delete;
+
+    void open(uint32_t periodNs, uint32_t dutyNs);  // throws std::runtime_error
+    void close();                                   // disable and unexport; never throws
+
+    int setDuty(uint32_t dutyNs) noexcept;
+    int setPeriod(uint32_t periodNs) noexcept;
+    int setEnabled(bool on) noexcept;
+
+    bool isOpen() const { return dutyFd_ != -1; }
+    const std::string& path() const { return pwmPath_; }
+    // sysfs writes the last open() needed, export included; 0 if it was already set up.
+    unsigned setupWrites() const { return setupWrites_; }
+
+private:
+    static int writeValue(int fd, uint32_t value) noexcept;
+    static bool readValue(int fd, uint32_t& value) noexcept;
+    static int openAttr(const std::string& path);
+
+    std::string chipPath_;
+    unsigned int channel_;
+    std::string pwmPath_;
+
+    int periodFd_ = -1;
+    int dutyFd_ = -1;
+    int enableFd_ = -1;
+    unsigned setupWrites_ = 0;
+};
+
+} // namespace hal
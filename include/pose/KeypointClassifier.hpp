@@ -0,0 +1,105 @@
+#pragma once
+#include "app/CommandProtocol.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Turns raw pose keypoints into the servo/stepper commands the inference
+ * side used to compute itself.
+ *
+ * A frame is the 17 COCO keypoints as (x, y, confidence) float32 triples,
+ * x and y normalised to the image (0..1). For every frame the angles of
+ * eight joints (elbows, shoulders, hips and knees, left and right) are
+ * computed in two 4-lane vector passes, then smoothed per joint with an
+ * exponential moving average. The configured driver joint is thresholded
+ * with hysteresis into a pose code: extended → 2, flexed → 4, 3 between.
+ * The hip midpoint drifting off-centre produces stepper jogs toward it.
+ *
+ * Angles are never materialised on the hot path. Each joint is carried as
+ * its signed squared cosine, cos·|cos|, which is monotonic in the angle, so
+ * thresholds compare directly and no sqrt or acos is needed.
+ *
+ * Not thread-safe; App drives it from the socket loop only.
+ */
+namespace pose {
+
+constexpr size_t kKeypoints = 17;
+constexpr size_t kFrameFloats = kKeypoints * 3;
+constexpr size_t kFrameBytes = kFrameFloats * sizeof(float);
+constexpr size_t kJoints = 8;
+
+/** Joint pairs, left and right; lane = 2 * joint (+1 for the right side). */
+enum class Joint : uint8_t { Elbow, Shoulder, Hip, Knee };
+
+const char* name(Joint j);
+
+struct ClassifierConfig {
+    Joint driver = Joint::Elbow;
+    float bottomDeg = 150.0f;       // more open than this → pose 2
+    float topDeg = 70.0f;           // more closed than this → pose 4
+    float hysteresisDeg = 10.0f;    // needed to leave pose 2 or 4 again
+    float minConfidence = 0.3f;     // per keypoint; lower makes the joint invalid
+    float smoothing = 0.4f;         // EMA weight of the newest frame, (0, 1]
+
+    float centerX = 0.5f;           // where the stepper keeps the subject
+    float lateralDeadband = 0.12f;  // |hip x - centerX| beyond this jogs the stepper
+    float lateralHysteresis = 0.04f;
+};
+
+/** Per-frame kernel output: signed squared cosines and their validity. */
+struct JointSample {
+    alignas(16) std::array<float, kJoints> cos2;
+    uint32_t valid = 0;   // bit per lane
+    float hipX = 0.0f;
+    bool hipValid = false;
+};
+
+class KeypointClassifier {
+public:
+    static constexpr size_t kBatch = 16;               // frames per kernel pass
+    static constexpr size_t kMaxCommandsPerFrame = 2;  // one pose, at most one jog
+
+    explicit KeypointClassifier(const ClassifierConfig& cfg = {});
+
+    /**
+     * Vector kernel: joint cosines of `count` frames of kFrameBytes each.
+     * A lane is valid when its three keypoints reach minConfidence.
+     * `frames` need not be aligned. Stateless.
+     */
+    static void measure(const uint8_t* frames, size_t count, float minConfidence, JointSample* out);
+
+    /** Advance the smoothing and hysteresis state by one sample; returns commands written. */
+    size_t step(const JointSample& sample, proto::Command* out);
+
+    /**
+     * measure() + step() over `count` frames, kBatch at a time. `out` needs
+     * room for kMaxCommandsPerFrame * count commands; returns how many were
+     * written. Commands carry only op and arg.
+     */
+    size_t classify(const uint8_t* frames, size_t count, proto::Command* out);
+
+    void reset();
+
+    uint64_t frames() const { return frames_; }
+    uint64_t lowConfidence() const { return lowConfidence_; }  // frames without a usable driver joint
+    int pose() const { return pose_; }                          // last pose code, 0 before the first
+    /** Smoothed angle of one lane in degrees, or -1 if it has never been valid. */
+    float angleDeg(size_t lane) const;
+
+private:
+    ClassifierConfig cfg_;
+    // Thresholds in cos·|cos| space.
+    float enterBottom_, leaveBottom_, enterTop_, leaveTop_;
+
+    alignas(16) std::array<float, kJoints> ema_{};
+    uint32_t seen_ = 0;
+    float hipX_ = 0.0f;
+    bool hipSeen_ = false;
+    int pose_ = 0;
+    int zone_ = 0;   // -1 left of centre, 0 inside the deadband, +1 right
+    uint64_t frames_ = 0;
+    uint64_t lowConfidence_ = 0;
+};
+
+} // namespace pose
@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace util {
+
+/** What push() does when the queue is full (or, for coalescing, not empty). */
+enum class OverflowPolicy : uint8_t {
+    Reject,          // keep the queued items, fail the push
+    DropOldest,      // evict the oldest item to make room
+    CoalesceLatest,  // discard everything still queued; only the newest survives
+};
+
+struct QueueStats {
+    uint64_t pushed = 0;
+    uint64_t rejected = 0;    // Reject: pushes that failed
+    uint64_t overflowed = 0;  // DropOldest: items evicted to make room
+    uint64_t coalesced = 0;   // CoalesceLatest: items superseded before the consumer saw them
+};
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * Bounded lock-free multi-producer queue (Vyukov's sequence-numbered ring).
+ * Any thread may push; one consumer thread pops. Producers also pop when the
+ * overflow policy needs to evict, which the algorithm supports because it
+ * is MPMC-safe.
+ *
+ * An idle consumer spins for a short while in popWait() and then parks on
+ * an atomic wait. Producers only issue the wake syscall when a consumer is
+ * actually parked, so the steady-state push is a handful of atomics.
+ */
+template <class T>
+class BoundedQueue {
+public:
+    BoundedQueue(size_t capacity, OverflowPolicy policy)
+        : cells_(new Cell[capacity]), mask_(capacity - 1), policy_(policy) {
+        if (capacity < 2 || (capacity & mask_) != 0) {
+            throw std::invalid_argument("BoundedQueue capacity must be a power of two >= 2");
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * Enqueue according to the overflow policy. False only under Reject.
+     * When given, *evicted receives how many older items this push dropped
+     * under DropOldest (superseded items under CoalesceLatest are not drops).
+     */
+    bool push(const T& value, uint64_t* evicted = nullptr) {
+        switch (policy_) {
+            case OverflowPolicy::Reject:
+                if (!tryPush(value)) {
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
+            case OverflowPolicy::DropOldest: {
+                T old;
+                uint64_t n = 0;
+                while (!tryPush(value)) {
+                    if (tryPop(old)) ++n;
+                }
+                if (n) overflowed_.fetch_add(n, std::memory_order_relaxed);
+                if (evicted) *evicted = n;
+                break;
+            }
+            case OverflowPolicy::CoalesceLatest: {
+                T old;
+                uint64_t n = 0;
+                do {
+                    while (tryPop(old)) ++n;
+                } while (!tryPush(value));
+                if (n) coalesced_.fetch_add(n, std::memory_order_relaxed);
+                break;
+            }
+        }
+        pushed_.fetch_add(1, std::memory_order_relaxed);
+        notify();
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = cell.value;
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Pop one item, spinning up to spinIters polls and then parking.
+     * Returns false once `running` is cleared and wakeAll() has been called.
+     */
+    bool popWait(T& out, const std::atomic<bool>& running, int spinIters = 256) {
+        for (;;) {
+            for (int i = 0; i < spinIters; ++i) {
+                if (tryPop(out)) return true;
+                if (!running.load(std::memory_order_relaxed)) return false;
+                cpuRelax();
+            }
+
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            uint32_t seen = signal_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (tryPop(out)) {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (!running.load(std::memory_order_acquire)) {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            signal_.wait(seen, std::memory_order_acquire);
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    /** Wake any parked consumer unconditionally (used on shutdown). */
+    void wakeAll() {
+        signal_.fetch_add(1, std::memory_order_release);
+        signal_.notify_all();
+    }
+
+    QueueStats stats() const {
+        QueueStats s;
+        s.pushed = pushed_.load(std::memory_order_relaxed);
+        s.rejected = rejected_.load(std::memory_order_relaxed);
+        s.overflowed = overflowed_.load(std::memory_order_relaxed);
+        s.coalesced = coalesced_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+    size_t memoryBytes() const { return capacity() * sizeof(Cell); }
+    OverflowPolicy policy() const { return policy_; }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value{};
+    };
+
+    bool tryPush(const T& value) {
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void notify() {
+        // Pairs with the fence in popWait(): either we see the waiter or it sees our item.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0) wakeAll();
+    }
+
+    std::unique_ptr<Cell[]> cells_;
+    const size_t mask_;
+    const OverflowPolicy policy_;
+
+    alignas(kCacheLine) std::atomic<size_t> enqueuePos_{0};
+    alignas(kCacheLine) std::atomic<size_t> dequeuePos_{0};
+    alignas(kCacheLine) std::atomic<uint32_t> signal_{0};
+    std::atomic<uint32_t> waiters_{0};
+
+    alignas(kCacheLine) std::atomic<uint64_t> pushed_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> overflowed_{0};
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+} // namespace util
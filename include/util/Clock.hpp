@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <time.h>
+
+namespace util {
+
+// CLOCK_MONOTONIC in nanoseconds. Same clock as Python's time.monotonic_ns(),
+// so timestamps taken by a co-located sender compare directly.
+inline uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace util
@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+/**
+ * Log-linear histogram of nanosecond values: 16 linear sub-buckets per power
+ * of two, so any recorded value is reported within ~6%. record() is a few
+ * relaxed atomics and never allocates; readers may query it concurrently
+ * from another thread and get a slightly torn but usable snapshot.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBits = 4;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+    void record(uint64_t v) {
+        buckets_[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(v, std::memory_order_relaxed);
+        uint64_t m = max_.load(std::memory_order_relaxed);
+        while (v > m && !max_.compare_exchange_weak(m, v, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    uint64_t mean() const {
+        uint64_t n = count();
+        return n ? sum_.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    /** Upper bound of the bucket holding the p-th percentile (0 < p <= 100). */
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * double(n) + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t upper = bucketUpper(i);
+                uint64_t m = max();
+                return upper < m ? upper : m;
+            }
+        }
+        return max();
+    }
+
+    /** Add another histogram's samples into this one (readers use this to merge shards). */
+    void mergeFrom(const LatencyHistogram& o) {
+        for (size_t i = 0; i < kBuckets; ++i) {
+            uint64_t n = o.buckets_[i].load(std::memory_order_relaxed);
+            if (n) buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+        count_.fetch_add(o.count(), std::memory_order_relaxed);
+        sum_.fetch_add(o.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        uint64_t m = o.max();
+        uint64_t cur = max_.load(std::memory_order_relaxed);
+        while (m > cur && !max_.compare_exchange_weak(cur, m, std::memory_order_relaxed)) {
+        }
+    }
+
+    void reset() {
+        for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static size_t bucketOf(uint64_t v) {
+        if (v < kSubBuckets) return size_t(v);
+        unsigned e = 63u - unsigned(__builtin_clzll(v));
+        size_t sub = size_t(v >> (e - kSubBits)) & (kSubBuckets - 1);
+        return (e - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    static uint64_t bucketUpper(size_t idx) {
+        if (idx < kSubBuckets) return idx;
+        unsigned e = unsigned(idx / kSubBuckets) + kSubBits - 1;
+        uint64_t sub = idx % kSubBuckets;
+        uint64_t width = uint64_t(1) << (e - kSubBits);
+        return ((kSubBuckets + sub) << (e - kSubBits)) + width - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace util
@@ -0,0 +1,197 @@
+#pragma once
+#include "util/Clock.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Asynchronous structured logger.
+ *
+ * A call site writes one fixed-size binary record (timestamp, level, event
+ * id, up to kMaxArgs arguments) into a ring owned by the calling thread. No
+ * lock is taken and nothing is formatted there. A background thread drains
+ * every ring every few milliseconds, orders the records by timestamp and
+ * formats them against the event's format string: Info goes to stdout,
+ * Warn and Error to stderr. If a thread's ring is full, the record is
+ * dropped and counted. The writer never waits.
+ *
+ * String arguments are copied into the record and truncated to fit, so
+ * the caller's buffer may be reused as soon as the call returns.
+ */
+namespace logging {
+
+enum class Level : uint8_t { Info, Warn, Error };
+
+// X(id, format): "{}" placeholders are filled with the arguments in order.
+#define WT_LOG_EVENTS(X)                                                           \
+    X(Line, "{}")                                                                  \
+    X(LinePart, "{}") /* a long line continues in the next record */              \
+    X(Dropped, "[log] {} records dropped (ring full)")                             \
+    X(AppError, "[app] {}")                                                        \
+    X(AppErrno, "[app] {}: {}")                                                    \
+    X(AppActuators, "[app] {} steppers and {} servos from {}")                     \
+    X(AppRecording, "[app] Recording commands to {}")                              \
+    X(AppListening, "[app] Listening on port {}...")                               \
+    X(AppShmRing, "[app] Shared-memory ring at {}")                                \
+    X(AppStarted, "[app] Started.")                                                \
+    X(AppStartup, "[app] Ready in {} us (init {} us; actuators {} us alongside listener {} us, command log {} us, telemetry {} us)") \
+    X(AppStopped, "[app] Stopped.")                                                \
+    X(AppStats, "[app] Stats on unix:{}")                                          \
+    X(AppClientConnected, "[app] Client connected (fd {})")                        \
+    X(AppProtocolError, "[app] Protocol error; closing fd {}")                     \
+    X(AppClientDisconnected, "[app] Client disconnected (fd {})")                  \
+    X(AppFramed, "[app] fd {} negotiated framed protocol v{}")                     \
+    X(AppUnknownPose, "[app] Unknown pose cmd {}")                                 \
+    X(AppBadKeypoints, "[app] Malformed keypoint frame: {} payload bytes")         \
+    X(AppUnknownOp, "[app] Unknown op {}")                                         \
+    X(AppJogNoDirection, "[app] Jog for actuator {} has no direction (arg 0); dropped") \
+    X(AppNotRouted, "[app] No actuator {} for op {}; dropped")                     \
+    X(AppReportHeader, "[app] {}:")                                                \
+    X(AppExecMode, "[app] {} mode: cpu {} ms over {} s, {} context switches/s")    \
+    X(AppQueue, "[app] {} queue: pushed {}, overflowed {}, coalesced {}, rejected {}") \
+    X(AppTimingError, "[app] {} timing error: p50 {} us, p99 {} us, max {} us over {} steps") \
+    X(AppReaction, "[app] {} reaction: p50 {} us, p99 {} us, max {} us; position {}") \
+    X(AppServoWrites, "[app] {}: {} duty writes over {} ticks, {} errors")         \
+    X(AppShmDrops, "[app] shm producer drops: {}")                                 \
+    X(AppCommandLog, "[app] command log: {} records, {} dropped (log full)")       \
+    X(AppLogStats, "[app] log: {} records, {} dropped (ring full)")                \
+    X(AppTelemetry, "[app] Telemetry to {} (spill: {})")                           \
+    X(AppTelemetryStats, "[app] telemetry: {} records sent in {} batches, {} bytes on the wire, {} spilled, {} dropped") \
+    X(StepperConfigured, "[Stepper] GPIO lines configured")                        \
+    X(StepperStarted, "[Stepper] Started using {}")                                \
+    X(StepperStartedPolled, "[Stepper] Started using {} (polled)")                 \
+    X(StepperStopped, "[Stepper] Stopped.")                                        \
+    X(ServoStarted, "[Servo] Started on {}")                                       \
+    X(ServoStartedPolled, "[Servo] Started on {} (polled)")                        \
+    X(ServoStopped, "[Servo] Stopped")                                             \
+    X(ServoWriteFailed, "[Servo] Failed to update duty cycle: {}")                 \
+    X(TelemetryUnreachable, "[telemetry] {} unreachable; retrying in {} ms")       \
+    X(TelemetryFailed, "[telemetry] {} answered {}; retrying in {} ms")            \
+    X(TelemetryRefused, "[telemetry] {} answered {}; dropped {} records")          \
+    X(TelemetryRecovered, "[telemetry] {} reachable again; {} spilled batches to resend") \
+    X(TelemetrySpillFailed, "[telemetry] Cannot write {}; batch dropped")          \
+    X(PinFailed, "{} Failed to pin to CPU {}: {}")                                 \
+    X(RtUnavailable, "{} SCHED_FIFO {} unavailable: {}")
+
+enum class Event : uint16_t {
+#define WT_LOG_ENUM(id, fmt) id,
+    WT_LOG_EVENTS(WT_LOG_ENUM)
+#undef WT_LOG_ENUM
+};
+
+const char* format(Event e);
+
+constexpr size_t kMaxArgs = 6;
+constexpr size_t kTextBytes = 56;
+
+enum class ArgType : uint8_t { I64, U64, F64, Str };
+
+/** One log call as it sits in a ring. Str arguments hold an offset into text. */
+struct Record {
+    uint64_t tsNs;
+    uint16_t event;
+    Level level;
+    uint8_t nargs;
+    ArgType types[kMaxArgs];
+    uint64_t args[kMaxArgs];
+    char text[kTextBytes];
+};
+static_assert(sizeof(Record) == 128, "log records should stay two cache lines");
+
+namespace detail {
+
+// Claim the calling thread's next ring slot, or null (and count a drop) if it is full.
+Record* claim();
+// Publish the slot claim() returned.
+void commit();
+
+struct Encoder {
+    Record& rec;
+    size_t textUsed = 0;
+
+    void put(ArgType t, uint64_t v) {
+        rec.types[rec.nargs] = t;
+        rec.args[rec.nargs++] = v;
+    }
+    void putStr(std::string_view s) {
+        if (textUsed == kTextBytes) {  // out of room: point at the last terminator
+            put(ArgType::Str, kTextBytes - 1);
+            return;
+        }
+        size_t n = std::min(s.size(), kTextBytes - textUsed - 1);
+        std::memcpy(rec.text + textUsed, s.data(), n);
+        rec.text[textUsed + n] = '\0';
+        put(ArgType::Str, textUsed);
+        textUsed += n + 1;
+    }
+
+    template <class T>
+    void operator()(const T& v) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            put(ArgType::U64, v ? 1 : 0);
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            put(ArgType::I64, uint64_t(int64_t(v)));
+        } else if constexpr (std::is_integral_v<U>) {
+            put(ArgType::U64, uint64_t(v));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            double d = double(v);
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            put(ArgType::F64, bits);
+        } else if constexpr (std::is_convertible_v<const U&, const char*>) {
+            const char* s = v;
+            putStr(s ? std::string_view(s) : std::string_view("(null)"));
+        } else {
+            putStr(std::string_view(v));
+        }
+    }
+};
+
+} // namespace detail
+
+template <class... Args>
+void write(Level level, Event event, const Args&... args) {
+    static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+    Record* rec = detail::claim();
+    if (!rec) return;
+    rec->tsNs = util::monotonicNs();
+    rec->event = uint16_t(event);
+    rec->level = level;
+    rec->nargs = 0;
+    [[maybe_unused]] detail::Encoder enc{*rec};
+    (enc(args), ...);
+    detail::commit();
+}
+
+template <class... Args>
+void info(Event event, const Args&... args) {
+    write(Level::Info, event, args...);
+}
+template <class... Args>
+void warn(Event event, const Args&... args) {
+    write(Level::Warn, event, args...);
+}
+template <class... Args>
+void error(Event event, const Args&... args) {
+    write(Level::Error, event, args...);
+}
+
+/** Log each line of a multi-line block; long lines span several records. */
+void lines(Level level, std::string_view text);
+
+/** Format and write everything logged so far, on the calling thread. */
+void flush();
+
+/** Where Info and Warn/Error lines go (stdout and stderr by default). */
+void setOutput(FILE* info, FILE* errors);
+
+/** Records accepted and records dropped on a full ring, over all threads. */
+uint64_t written();
+uint64_t dropped();
+
+} // namespace logging
@@ -0,0 +1,83 @@
+#pragma once
+#include "util/LatencyHistogram.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Process-wide command-path instrumentation.
+ *
+ * Every command carries CLOCK_MONOTONIC stamps taken at ingress (recv or
+ * ring drain), at enqueue into a controller and at dequeue by the
+ * controller. When the controller acts on it, the time between each
+ * pair of stamps is recorded as one Stage. Histograms and counters are
+ * sharded per thread, so recording is a few uncontended relaxed atomics
+ * and never blocks or allocates. Readers merge the shards on demand.
+ */
+namespace metrics {
+
+enum class Stage : uint8_t {
+    Ingress,   // sender timestamp → recv (framed sources only)
+    Enqueue,   // recv → pushed to the controller queue
+    Dequeue,   // pushed → taken by the controller thread
+    Actuate,   // taken → GPIO/PWM write
+    EndToEnd,  // recv → GPIO/PWM write
+};
+constexpr size_t kStages = 5;
+
+enum class Counter : uint8_t {
+    Commands,        // dispatched to a controller
+    Unknown,         // undecodable byte or op
+    Stale,           // framed command older than maxFrameAgeMs
+    OutOfOrder,      // framed command with a non-increasing sequence number
+    NotReady,        // target controller missing
+    ProtocolErrors,  // connections closed for malformed frames
+    Dropped,         // evicted from or rejected by a full controller queue
+};
+constexpr size_t kCounters = 7;
+
+const char* name(Stage s);
+const char* name(Counter c);
+
+struct StageSummary {
+    uint64_t count = 0;
+    uint64_t mean = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+class Registry {
+public:
+    static constexpr size_t kShards = 8;
+
+    void record(Stage s, uint64_t ns) { shard().stages[size_t(s)].record(ns); }
+    void add(Counter c, uint64_t n = 1) {
+        shard().counters[size_t(c)].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t counter(Counter c) const;
+    StageSummary summary(Stage s) const;
+    void reset();
+
+    // Stage and counter fields only; App wraps these with controller state.
+    void appendJson(std::string& out) const;
+    void appendText(std::string& out) const;
+
+private:
+    struct alignas(64) Shard {
+        std::array<util::LatencyHistogram, kStages> stages;
+        std::array<std::atomic<uint64_t>, kCounters> counters{};
+    };
+
+    Shard& shard();
+
+    std::array<Shard, kShards> shards_;
+};
+
+Registry& registry();
+
+} // namespace metrics
@@ -0,0 +1,302 @@
+#include "analytics/WorkoutAnalyzer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <thread>
+#include <time.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace analytics {
+
+namespace {
+
+void addTotals(Totals& into, const Totals& t) {
+    into.reps += t.reps;
+    into.partials += t.partials;
+    into.tutNs += t.tutNs;
+    into.concentricNs += t.concentricNs;
+    into.pauseNs += t.pauseNs;
+    into.eccentricNs += t.eccentricNs;
+    into.romMilliDeg += t.romMilliDeg;
+    into.maxRomMilliDeg = std::max(into.maxRomMilliDeg, t.maxRomMilliDeg);
+}
+
+uint64_t avg(uint64_t sum, uint32_t n) {
+    return n ? sum / n : 0;
+}
+
+std::string ms(uint64_t ns) {
+    return std::to_string(ns / 1000000);
+}
+
+std::string secs(uint64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f s", double(ns) / 1e9);
+    return buf;
+}
+
+std::string degrees(uint64_t milliDeg) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.1f deg", double(milliDeg) / 1000.0);
+    return buf;
+}
+
+} // namespace
+
+const char* name(Phase p) {
+    switch (p) {
+        case Phase::Idle: return "idle";
+        case Phase::Bottom: return "bottom";
+        case Phase::Concentric: return "concentric";
+        case Phase::Top: return "top";
+        case Phase::Eccentric: return "eccentric";
+    }
+    return "?";
+}
+
+WorkoutAnalyzer::WorkoutAnalyzer(const AnalyzerConfig& cfg)
+    : cfg_(cfg), span_(double(cfg.bottomMilliDeg) - double(cfg.topMilliDeg)) {
+    if (span_ == 0.0 || !(cfg_.leaveBottom < cfg_.reachTop)) {
+        throw std::invalid_argument("[analytics] Empty range or thresholds out of order");
+    }
+}
+
+void WorkoutAnalyzer::reset() {
+    *this = WorkoutAnalyzer(cfg_);
+}
+
+double WorkoutAnalyzer::normalised(int32_t milliDeg) const {
+    return (double(cfg_.bottomMilliDeg) - double(milliDeg)) / span_;
+}
+
+void WorkoutAnalyzer::onCommand(const proto::Command& cmd) noexcept {
+    if (cmd.actuator != cfg_.actuator) return;
+    if (firstEventNs_ == 0) firstEventNs_ = cmd.rxNs;
+    lastEventNs_ = cmd.rxNs;
+
+    switch (cmd.op) {
+        case proto::Op::ServoPose: {
+            int32_t milliDeg = proto::poseMilliDegrees(cmd.arg);
+            if (milliDeg >= 0) onPosition(milliDeg, cmd.rxNs);
+            break;
+        }
+        case proto::Op::ServoAngle:
+            onPosition(cmd.arg, cmd.rxNs);
+            break;
+        case proto::Op::StepperJog:
+            if (cmd.arg != 0) ++lateralShifts_;  // no direction: dropped by the route too
+            break;
+        default:
+            break;
+    }
+}
+
+void WorkoutAnalyzer::onPosition(int32_t milliDeg, uint64_t tNs) noexcept {
+    const double p = normalised(milliDeg);
+    if (phase_ != Phase::Idle && phase_ != Phase::Bottom) {
+        repMinMilliDeg_ = std::min(repMinMilliDeg_, milliDeg);
+        repMaxMilliDeg_ = std::max(repMaxMilliDeg_, milliDeg);
+    }
+
+    switch (phase_) {
+        case Phase::Idle:
+            // Reps are only counted from the bottom of the range.
+            if (p < cfg_.leaveBottom) {
+                phase_ = Phase::Bottom;
+                lastBottomNs_ = tNs;
+                repMinMilliDeg_ = repMaxMilliDeg_ = milliDeg;
+            }
+            break;
+        case Phase::Bottom:
+            if (p < cfg_.leaveBottom) {
+                lastBottomNs_ = tNs;
+                repMinMilliDeg_ = repMaxMilliDeg_ = milliDeg;
+                break;
+            }
+            beginRep(lastBottomNs_);
+            repMinMilliDeg_ = std::min(repMinMilliDeg_, milliDeg);
+            repMaxMilliDeg_ = std::max(repMaxMilliDeg_, milliDeg);
+            phase_ = Phase::Concentric;
+            [[fallthrough]];
+        case Phase::Concentric:
+            if (p >= cfg_.reachTop) {
+                phase_ = Phase::Top;
+                firstTopNs_ = lastTopNs_ = tNs;
+            } else if (p < cfg_.leaveBottom) {
+                endRep(tNs, false);
+            }
+            break;
+        case Phase::Top:
+        case Phase::Eccentric:
+            if (p >= cfg_.reachTop) {
+                // A bounce back to the top extends the pause rather than
+                // starting a second rep.
+                phase_ = Phase::Top;
+                lastTopNs_ = tNs;
+            } else if (p < cfg_.leaveBottom) {
+                endRep(tNs, true);
+            } else {
+                phase_ = Phase::Eccentric;
+            }
+            break;
+    }
+}
+
+Totals& WorkoutAnalyzer::currentSet() {
+    return sets_ <= kMaxSets ? setList_[sets_ - 1].totals : overflowSet_;
+}
+
+void WorkoutAnalyzer::beginRep(uint64_t tNs) {
+    if (sets_ == 0 || tNs - lastRepEndNs_ > cfg_.setRestNs) {
+        ++sets_;
+        if (sets_ <= kMaxSets) setList_[sets_ - 1].startNs = tNs;
+        else overflowSet_ = {};
+    }
+    repStartNs_ = tNs;
+}
+
+void WorkoutAnalyzer::endRep(uint64_t tNs, bool complete) {
+    const uint64_t tut = tNs - repStartNs_;
+    const int32_t rom = repMaxMilliDeg_ - repMinMilliDeg_;
+    auto add = [&](Totals& t) {
+        t.tutNs += tut;
+        if (!complete) {
+            ++t.partials;
+            return;
+        }
+        ++t.reps;
+        t.concentricNs += firstTopNs_ - repStartNs_;
+        t.pauseNs += lastTopNs_ - firstTopNs_;
+        t.eccentricNs += tNs - lastTopNs_;
+        t.romMilliDeg += uint64_t(rom);
+        t.maxRomMilliDeg = std::max(t.maxRomMilliDeg, rom);
+    };
+    add(totals_);
+    add(currentSet());
+    if (sets_ <= kMaxSets) setList_[sets_ - 1].endNs = tNs;
+
+    lastRepEndNs_ = tNs;
+    lastBottomNs_ = tNs;
+    phase_ = Phase::Bottom;
+}
+
+void WorkoutAnalyzer::appendJson(std::string& out) const {
+    const Totals& t = totals_;
+    out += "{\"phase\":\"";
+    out += name(phase_);
+    out += "\",\"reps\":" + std::to_string(t.reps) + ",\"partials\":" + std::to_string(t.partials) +
+           ",\"sets\":" + std::to_string(sets_) + ",\"lateral_shifts\":" + std::to_string(lateralShifts_) +
+           ",\"tut_ms\":" + ms(t.tutNs) +
+           ",\"tempo_ms\":{\"concentric\":" + ms(avg(t.concentricNs, t.reps)) +
+           ",\"pause\":" + ms(avg(t.pauseNs, t.reps)) + ",\"eccentric\":" + ms(avg(t.eccentricNs, t.reps)) +
+           "},\"rom_mdeg\":{\"avg\":" + std::to_string(avg(t.romMilliDeg, t.reps)) +
+           ",\"max\":" + std::to_string(t.maxRomMilliDeg) + "},\"per_set\":[";
+    for (size_t i = 0; i < sets_ && i < kMaxSets; ++i) {
+        const SetSummary& s = setList_[i];
+        if (i) out += ',';
+        out += "{\"reps\":" + std::to_string(s.totals.reps) + ",\"partials\":" + std::to_string(s.totals.partials) +
+               ",\"tut_ms\":" + ms(s.totals.tutNs) + ",\"duration_ms\":" + ms(s.endNs - s.startNs) + "}";
+    }
+    out += "]}";
+}
+
+void WorkoutAnalyzer::appendText(std::string& out, const char* indent) const {
+    const Totals& t = totals_;
+    out += indent;
+    out += std::to_string(t.reps) + " reps (" + std::to_string(t.partials) + " partial) in " +
+           std::to_string(sets_) + " sets, " + std::to_string(lateralShifts_) + " lateral shifts\n";
+    if (t.reps == 0) return;
+    out += indent;
+    out += "tempo: concentric " + ms(avg(t.concentricNs, t.reps)) + " ms, pause " +
+           ms(avg(t.pauseNs, t.reps)) + " ms, eccentric " + ms(avg(t.eccentricNs, t.reps)) +
+           " ms; time under tension " + secs(t.tutNs) + "\n";
+    out += indent;
+    out += "range of motion: avg " + degrees(avg(t.romMilliDeg, t.reps)) + ", max " +
+           degrees(uint64_t(t.maxRomMilliDeg)) + "\n";
+    for (size_t i = 0; i < sets_ && i < kMaxSets; ++i) {
+        const SetSummary& s = setList_[i];
+        out += indent;
+        out += "set " + std::to_string(i + 1) + ": " + std::to_string(s.totals.reps) + " reps, " +
+               secs(s.totals.tutNs) + " under tension\n";
+    }
+}
+
+SessionRecord WorkoutAnalyzer::summarize(uint64_t nowNs) const {
+    SessionRecord rec;
+    rec.recordSize = sizeof(SessionRecord);
+    if (firstEventNs_ != 0) {
+        timespec real{};
+        clock_gettime(CLOCK_REALTIME, &real);
+        uint64_t realNs = uint64_t(real.tv_sec) * 1000000000ull + uint64_t(real.tv_nsec);
+        rec.startRealNs = realNs - (nowNs - firstEventNs_);
+        rec.durationNs = lastEventNs_ - firstEventNs_;
+    }
+    const Totals& t = totals_;
+    rec.reps = t.reps;
+    rec.partials = t.partials;
+    rec.sets = sets_;
+    rec.lateralShifts = lateralShifts_;
+    rec.tutNs = t.tutNs;
+    rec.avgConcentricMs = uint32_t(avg(t.concentricNs, t.reps) / 1000000);
+    rec.avgPauseMs = uint32_t(avg(t.pauseNs, t.reps) / 1000000);
+    rec.avgEccentricMs = uint32_t(avg(t.eccentricNs, t.reps) / 1000000);
+    rec.avgRomMilliDeg = uint32_t(avg(t.romMilliDeg, t.reps));
+    rec.maxRomMilliDeg = uint32_t(t.maxRomMilliDeg);
+    for (size_t i = 0; i < sets_ && i < SessionRecord::kMaxSets; ++i) {
+        rec.setReps[i] = uint16_t(std::min<uint32_t>(setList_[i].totals.reps, UINT16_MAX));
+    }
+    return rec;
+}
+
+void WorkoutAnalyzer::merge(const WorkoutAnalyzer& other) {
+    if (other.firstEventNs_ == 0) return;
+    if (firstEventNs_ == 0 || other.lastEventNs_ > lastEventNs_) phase_ = other.phase_;
+    firstEventNs_ = firstEventNs_ ? std::min(firstEventNs_, other.firstEventNs_) : other.firstEventNs_;
+    lastEventNs_ = std::max(lastEventNs_, other.lastEventNs_);
+    lateralShifts_ += other.lateralShifts_;
+    addTotals(totals_, other.totals_);
+
+    // Keep the earliest kMaxSets sets of both; later ones only count.
+    std::array<SetSummary, 2 * kMaxSets> all;
+    size_t n = 0;
+    for (size_t i = 0; i < sets_ && i < kMaxSets; ++i) all[n++] = setList_[i];
+    for (size_t i = 0; i < other.sets_ && i < kMaxSets; ++i) all[n++] = other.setList_[i];
+    std::sort(all.begin(), all.begin() + n,
+              [](const SetSummary& a, const SetSummary& b) { return a.startNs < b.startNs; });
+    std::copy_n(all.begin(), std::min(n, kMaxSets), setList_.begin());
+    sets_ += other.sets_;
+}
+
+void AnalyzerShard::snapshot(WorkoutAnalyzer& out) const {
+    static_assert(std::is_trivially_copyable_v<WorkoutAnalyzer>, "snapshot copies the analyzer bytewise");
+    for (;;) {
+        const uint32_t seq = seq_.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::memcpy(static_cast<void*>(&out), &analyzer_, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == seq) return;
+    }
+}
+
+void appendSessionRecord(const std::string& path, const SessionRecord& rec) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("[analytics] Failed to open " + path + ": " + std::strerror(errno));
+    }
+    ssize_t n = write(fd, &rec, sizeof(rec));
+    int err = errno;
+    ::close(fd);
+    if (n != ssize_t(sizeof(rec))) {
+        throw std::runtime_error("[analytics] Failed to append to " + path + ": " +
+                                 (n < 0 ? std::strerror(err) : "short write"));
+    }
+}
+
+} // namespace analytics
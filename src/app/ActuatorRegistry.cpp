@@ -0,0 +1,236 @@
+#include "app/ActuatorRegistry.hpp"
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
+#include "util/Metrics.hpp"
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#ifdef WT_HAVE_YAML_CPP
+#include <yaml-cpp/yaml.h>
+#endif
+
+namespace {
+
+bool unknownOp(void*, const proto::Command& cmd) {
+    metrics::registry().add(metrics::Counter::Unknown);
+    logging::warn(logging::Event::AppUnknownOp, int(cmd.op));
+    return false;
+}
+
+bool notRouted(void*, const proto::Command& cmd) {
+    metrics::registry().add(metrics::Counter::NotReady);
+    logging::warn(logging::Event::AppNotRouted, int(cmd.actuator), int(cmd.op));
+    return true;
+}
+
+template <StepperCommand::Kind K>
+bool stepper(void* target, const proto::Command& cmd) {
+    int32_t value = cmd.arg;
+    if constexpr (K == StepperCommand::Kind::Jog) {
+        // The protocol only defines > 0 (clockwise) and < 0 (counter-clockwise).
+        if (cmd.arg == 0) {
+            metrics::registry().add(metrics::Counter::Unknown);
+            logging::warn(logging::Event::AppJogNoDirection, int(cmd.actuator));
+            return false;
+        }
+        value = cmd.arg > 0 ? 1 : -1;
+    }
+    if constexpr (K == StepperCommand::Kind::Stop) value = 0;
+    StepperCommand sc{K, value};
+    sc.rxNs = cmd.rxNs;
+    static_cast<StepperController*>(target)->pushCommand(sc);
+    metrics::registry().add(metrics::Counter::Commands);
+    return true;
+}
+
+bool servoPose(void* target, const proto::Command& cmd) {
+    static_cast<ServoController*>(target)->pushCommand(cmd.arg, cmd.rxNs);
+    metrics::registry().add(metrics::Counter::Commands);
+    return true;
+}
+
+bool servoAngle(void* target, const proto::Command& cmd) {
+    static_cast<ServoController*>(target)->pushAngle(cmd.arg, cmd.rxNs);
+    metrics::registry().add(metrics::Counter::Commands);
+    return true;
+}
+
+} // namespace
+
+std::vector<ActuatorSpec> defaultActuators() {
+    ActuatorSpec stepper;
+    stepper.kind = ActuatorSpec::Kind::Stepper;
+    stepper.name = "stepper";
+    stepper.lines = {105, 106, 41, 43};
+
+    ActuatorSpec servo;
+    servo.kind = ActuatorSpec::Kind::Servo;
+    servo.name = "servo";
+    return {stepper, servo};
+}
+
+#ifdef WT_HAVE_YAML_CPP
+
+std::vector<ActuatorSpec> loadActuators(const std::string& path) {
+    std::vector<ActuatorSpec> specs;
+    try {
+        YAML::Node root = YAML::LoadFile(path);
+        for (const YAML::Node& node : root["actuators"]) {
+            ActuatorSpec spec;
+            const std::string type = node["type"].as<std::string>();
+            spec.name = node["name"].as<std::string>();
+            int id = node["id"].as<int>(0);
+            if (id < 0 || id > 255) {
+                throw std::runtime_error(spec.name + ": id " + std::to_string(id) + " is outside 0..255");
+            }
+            spec.id = uint8_t(id);
+
+            if (type == "stepper") {
+                spec.kind = ActuatorSpec::Kind::Stepper;
+                spec.chip = node["chip"].as<std::string>(spec.chip);
+                spec.lines = node["lines"].as<std::vector<unsigned int>>();
+                if (spec.lines.size() != StepperController::kCoils) {
+                    throw std::runtime_error(spec.name + ": a stepper needs " +
+                                             std::to_string(StepperController::kCoils) + " lines");
+                }
+                MotionProfile& p = spec.timing.profile;
+                p.startStepsPerSec = node["start_steps_per_sec"].as<double>(p.startStepsPerSec);
+                p.maxStepsPerSec = node["max_steps_per_sec"].as<double>(p.maxStepsPerSec);
+                p.accelStepsPerSec2 = node["accel_steps_per_sec2"].as<double>(p.accelStepsPerSec2);
+                const std::string drive = node["drive"].as<std::string>(name(spec.drive));
+                if (!parseDriveMode(drive.c_str(), spec.drive)) {
+                    throw std::runtime_error(spec.name + ": unknown drive mode '" + drive + "'");
+                }
+                spec.timing.cpu = node["cpu"].as<int>(spec.timing.cpu);
+                spec.timing.rtPriority = node["rt_priority"].as<int>(spec.timing.rtPriority);
+            } else if (type == "servo") {
+                spec.kind = ActuatorSpec::Kind::Servo;
+                spec.pwmChip = node["pwm_chip"].as<std::string>(spec.pwmChip);
+                spec.channel = node["channel"].as<unsigned int>(spec.channel);
+                spec.motion.maxVelDegPerSec = node["max_velocity_deg_s"].as<double>(spec.motion.maxVelDegPerSec);
+                spec.motion.maxAccelDegPerSec2 =
+                    node["max_accel_deg_s2"].as<double>(spec.motion.maxAccelDegPerSec2);
+            } else {
+                throw std::runtime_error(spec.name + ": unknown actuator type '" + type + "'");
+            }
+            specs.push_back(std::move(spec));
+        }
+    } catch (const YAML::Exception& e) {
+        throw std::runtime_error("[actuators] " + path + ": " + e.what());
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error("[actuators] " + path + ": " + e.what());
+    }
+    return specs;
+}
+
+#else
+
+std::vector<ActuatorSpec> loadActuators(const std::string& path) {
+    throw std::runtime_error("[actuators] Cannot read " + path + ": built without yaml-cpp");
+}
+
+#endif
+
+ActuatorRegistry::ActuatorRegistry(const std::vector<ActuatorSpec>& specs) {
+    for (const ActuatorSpec& spec : specs) rows_ = std::max<size_t>(rows_, size_t(spec.id) + 2);
+
+    // Every cell starts unrouted; the last column and the last row stay that way.
+    table_.assign(rows_ * kOpColumns, Route{notRouted, nullptr});
+    for (size_t row = 0; row < rows_; ++row) {
+        table_[row * kOpColumns + size_t(proto::Op::None)] = {unknownOp, nullptr};
+        table_[row * kOpColumns + size_t(proto::Op::Keypoints)] = {unknownOp, nullptr};
+        table_[row * kOpColumns + kOpColumns - 1] = {unknownOp, nullptr};
+    }
+
+    auto route = [&](const ActuatorSpec& spec, proto::Op op, Handler fn, void* target) {
+        Route& cell = table_[size_t(spec.id) * kOpColumns + size_t(op)];
+        if (cell.target) {
+            throw std::invalid_argument("[actuators] " + spec.name + " reuses id " + std::to_string(spec.id) +
+                                        " for op " + std::to_string(int(op)));
+        }
+        cell = {fn, target};
+    };
+
+    for (const ActuatorSpec& spec : specs) {
+        if (spec.kind == ActuatorSpec::Kind::Stepper) {
+            auto ctl = std::make_unique<StepperController>(spec.lines, spec.chip, spec.timing, spec.drive);
+            void* t = ctl.get();
+            route(spec, proto::Op::StepperJog, stepper<StepperCommand::Kind::Jog>, t);
+            route(spec, proto::Op::StepperMoveTo, stepper<StepperCommand::Kind::MoveTo>, t);
+            route(spec, proto::Op::StepperMoveBy, stepper<StepperCommand::Kind::MoveBy>, t);
+            route(spec, proto::Op::StepperStop, stepper<StepperCommand::Kind::Stop>, t);
+            steppers_.push_back({spec.name, spec.id, std::move(ctl)});
+        } else {
+            auto ctl = std::make_unique<ServoController>(spec.pwmChip, spec.channel, spec.motion);
+            void* t = ctl.get();
+            route(spec, proto::Op::ServoPose, servoPose, t);
+            route(spec, proto::Op::ServoAngle, servoAngle, t);
+            servos_.push_back({spec.name, spec.id, std::move(ctl)});
+        }
+    }
+}
+
+void ActuatorRegistry::start() {
+    startAll(false);
+}
+
+void ActuatorRegistry::startPolled() {
+    startAll(true);
+}
+
+void ActuatorRegistry::startAll(bool polled) {
+    std::vector<std::function<void()>> jobs;
+    auto add = [&](auto& entry) {
+        jobs.push_back([&entry, polled] {
+            const uint64_t t0 = util::monotonicNs();
+            if (polled) {
+                entry.controller->startPolled();
+            } else {
+                entry.controller->start();
+            }
+            entry.setupNs = util::monotonicNs() - t0;
+        });
+    };
+    for (auto& s : steppers_) add(s);
+    for (auto& s : servos_) add(s);
+    if (jobs.empty()) return;
+
+    // The first job runs here, so a single actuator costs no thread.
+    std::vector<std::exception_ptr> errors(jobs.size());
+    auto run = [&](size_t i) {
+        try {
+            jobs[i]();
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(jobs.size() - 1);
+    for (size_t i = 1; i < jobs.size(); ++i) threads.emplace_back(run, i);
+    run(0);
+    for (auto& t : threads) t.join();
+
+    for (const std::exception_ptr& e : errors) {
+        if (e) {
+            stop();
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+void ActuatorRegistry::stop() {
+    for (auto& s : servos_) s.controller->stop();
+    for (auto& s : steppers_) s.controller->stop();
+}
+
+uint64_t ActuatorRegistry::poll(uint64_t nowNs) {
+    uint64_t next = 0;
+    auto earliest = [&next](uint64_t deadline) {
+        if (deadline != 0 && (next == 0 || deadline < next)) next = deadline;
+    };
+    for (auto& s : steppers_) earliest(s.controller->poll(nowNs));
+    for (auto& s : servos_) earliest(s.controller->poll(nowNs));
+    return next;
+}
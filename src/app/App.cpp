@@ -1,46 +1,199 @@
 #include "app/App.hpp"
-#include <iostream>
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
+#include "util/Metrics.hpp"
 #include <vector>
 #include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
+#include <exception>
+#include <stdexcept>
 
-App::App() = default;
+using logging::Event;
+
+App::App(AppConfig cfg)
+    : cfg_(cfg),
+      analytics_{analytics::AnalyzerShard(cfg_.analytics), analytics::AnalyzerShard(cfg_.analytics),
+                 analytics::AnalyzerShard(cfg_.analytics)},
+      keypoints_(cfg_.pose) {}
+
+static void printQueueStats(const std::string& name, const util::QueueStats& q) {
+    logging::info(Event::AppQueue, name, q.pushed, q.overflowed, q.coalesced, q.rejected);
+}
 
 App::~App() {
     stop();
 }
 
 void App::init() {
-    std::vector<unsigned int> pins = {105, 106, 41, 43};
-    stepper_ = std::make_unique<StepperController>(pins);
-    servo_ = std::make_unique<ServoController>("/sys/class/pwm/pwmchip0", 0);
+    const uint64_t t0 = util::monotonicNs();
+    if (cfg_.actuatorConfigPath.empty()) {
+        actuators_ = std::make_unique<ActuatorRegistry>(defaultActuators());
+    } else {
+        actuators_ = std::make_unique<ActuatorRegistry>(loadActuators(cfg_.actuatorConfigPath));
+        logging::info(Event::AppActuators, actuators_->steppers().size(), actuators_->servos().size(),
+                      cfg_.actuatorConfigPath);
+    }
+    if (!cfg_.shmRingPath.empty()) {
+        shm_ring_ = std::make_unique<shm::RingReader>(cfg_.shmRingPath, cfg_.shmRingCapacity);
+    }
+    if (!cfg_.commandLogPath.empty()) {
+        cmd_log_ = std::make_unique<cmdlog::Writer>(cfg_.commandLogPath, cfg_.commandLogCapacity);
+    }
+    if (!cfg_.telemetry.url.empty()) {
+        telemetry_ = std::make_unique<telemetry::Uploader>(cfg_.telemetry);
+        telemetry_->setSampler([this](telemetry::Uploader& up) { sampleTelemetry(up); });
+    }
+    startup_.initNs = util::monotonicNs() - t0;
 }
 
 void App::start() {
     if (running_.exchange(true)) return;
     stop_requested_ = false;
+    started_ns_ = util::monotonicNs();
+    startup_ = {startup_.initNs};
+    auto since = [](uint64_t t0) { return util::monotonicNs() - t0; };
 
-    if (stepper_) stepper_->start();
-    if (servo_) servo_->start();
+    // Actuator bring-up (GPIO requests, PWM export) is the slow part of
+    // startup and shares nothing with the steps below, so it runs alongside them.
+    std::exception_ptr actuatorError;
+    std::thread bringUp;
+    if (actuators_) {
+        bringUp = std::thread([this, &actuatorError, since] {
+            const uint64_t t0 = util::monotonicNs();
+            try {
+                if (cfg_.execMode == ExecMode::Reactor) {
+                    actuators_->startPolled();
+                } else {
+                    actuators_->start();
+                }
+            } catch (...) {
+                actuatorError = std::current_exception();
+            }
+            startup_.actuatorsNs = since(t0);
+        });
+    }
+
+    try {
+        uint64_t t0 = util::monotonicNs();
+        if (cmd_log_) {
+            cmd_log_->open();
+            logging::info(Event::AppRecording, cmd_log_->path());
+        }
+        startup_.commandLogNs = since(t0);
 
-    // Launch a simple loop thread.
+        t0 = util::monotonicNs();
+        if (telemetry_) {
+            telemetry_->start();
+            logging::info(Event::AppTelemetry, telemetry_->url(),
+                          cfg_.telemetry.spillDir.empty() ? "none" : cfg_.telemetry.spillDir.c_str());
+        }
+        startup_.telemetryNs = since(t0);
+
+        // Open the listener here rather than on the loop thread, so returning
+        // from start() means commands are accepted and bind errors reach main.
+        t0 = util::monotonicNs();
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (!openServer()) throw std::runtime_error("[app] Cannot listen on port " + std::to_string(cfg_.port));
+        startup_.listenNs = since(t0);
+        logging::info(Event::AppListening, cfg_.port);
+
+        if (bringUp.joinable()) bringUp.join();
+        if (actuatorError) std::rethrow_exception(actuatorError);
+        if (cfg_.execMode == ExecMode::Reactor && !openTimer()) {
+            throw std::runtime_error("[app] Cannot create the controller timer");
+        }
+
+        t0 = util::monotonicNs();
+        if (shm_ring_) {
+            shm_ring_->open();
+            shm_seq_ = {};
+            shm_thread_ = std::thread(&App::shmThreadFunc, this);
+            logging::info(Event::AppShmRing, shm_ring_->path());
+        }
+        startup_.shmNs = since(t0);
+    } catch (...) {
+        if (bringUp.joinable()) bringUp.join();
+        abortStart();
+        throw;
+    }
+
+    // Launch the command reactor.
     loop_thread_ = std::thread(&App::loopThreadFunc, this);
 
-    std::cout << "[app] Started.\n";
+    startup_.readyNs = since(started_ns_);
+    logging::info(Event::AppStarted);
+    logging::info(Event::AppStartup, startup_.readyNs / 1000, startup_.initNs / 1000, startup_.actuatorsNs / 1000,
+                  startup_.listenNs / 1000, startup_.commandLogNs / 1000, startup_.telemetryNs / 1000);
+}
+
+// Undo whatever start() got through before it failed.
+void App::abortStart() {
+    if (shm_ring_) shm_ring_->close();
+    if (actuators_) actuators_->stop();
+    closeServer();
+    if (wake_fd_ != -1) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    if (telemetry_) telemetry_->stop();
+    if (cmd_log_) cmd_log_->close();
+    running_ = false;
 }
 
 void App::stop() {
     if (!running_.exchange(false)) return;
     stop_requested_ = true;
-    closeServer();
+    if (wake_fd_ != -1) {
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+    if (shm_ring_) shm_ring_->wake();
+    if (shm_thread_.joinable()) shm_thread_.join();
     if (loop_thread_.joinable()) loop_thread_.join();
-    
-    if (servo_) servo_->stop();
-    if (stepper_) stepper_->stop();
+    closeServer();  // no-op unless start() failed before the loop ran
+    if (wake_fd_ != -1) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+
+    if (actuators_) actuators_->stop();
 
-    std::cout << "[app] Stopped.\n";
+    printStats();
+    const analytics::WorkoutAnalyzer session = workout();
+    const analytics::Totals& totals = session.totals();
+    if (!cfg_.sessionLogPath.empty() && totals.reps + totals.partials > 0) {
+        try {
+            analytics::appendSessionRecord(cfg_.sessionLogPath, session.summarize(util::monotonicNs()));
+        } catch (const std::exception& e) {
+            logging::lines(logging::Level::Error, e.what());
+        }
+    }
+    if (telemetry_) {
+        const analytics::SessionRecord summary = session.summarize(util::monotonicNs());
+        telemetry::Record rec;
+        rec.tsNs = util::monotonicNs();
+        rec.kind = telemetry::Kind::Session;
+        rec.session = {summary.reps, summary.partials, summary.sets, summary.lateralShifts, summary.tutNs,
+                       summary.durationNs};
+        telemetry_->push(rec);
+        telemetry_->stop();
+        const telemetry::UploaderStats t = telemetry_->stats();
+        logging::info(Event::AppTelemetryStats, t.sent, t.batches, t.wireBytes, t.spilled,
+                      t.queueDropped + t.lost + t.spillEvicted);
+    }
+    if (shm_ring_) shm_ring_->close();
+    if (cmd_log_) cmd_log_->close();
+    logging::info(Event::AppStopped);
+    // Stop is where main hands back to its own output; let it see ours first.
+    logging::flush();
 }
 
 void App::wait() {
@@ -48,93 +201,603 @@ void App::wait() {
     if (loop_thread_.joinable()) loop_thread_.join();
 }
 
-void App::loopThreadFunc() {
+void App::shmThreadFunc() {
+    constexpr int kSpinIters = 2000;
+    constexpr int kParkTimeoutMs = 100;
+
+    while (!stop_requested_) {
+        uint64_t rxNs = util::monotonicNs();
+        size_t n = shm_ring_->drain([&](const proto::FrameView& frame) {
+            if (acceptFrame(shm_seq_, frame, rxNs)) dispatchFrame(frame, rxNs, proto::Source::Shm);
+        });
+        if (n == 0) {
+            shm_ring_->waitForData(kSpinIters, kParkTimeoutMs, stop_requested_);
+        } else if (cfg_.execMode == ExecMode::Reactor) {
+            pokeReactor();
+        }
+    }
+}
+
+bool App::openServer() {
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(port_);
+    addr.sin_port = htons(cfg_.port);
 
-    server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    server_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd_ < 0) {
-        std::cerr << "[app] Socket creation failed\n";
-        return;
+        logging::error(Event::AppError, "Socket creation failed");
+        return false;
     }
 
     int opt = 1;
     setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
 
     if (bind(server_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        std::cerr << "[app] Bind failed\n";
-        closeServer();
-        return;
+        logging::error(Event::AppError, "Bind failed");
+        return false;
     }
 
-    if (listen(server_fd_, 1) < 0) {
-        std::cerr << "[app] Listen failed\n";
-        closeServer();
-        return;
+    if (listen(server_fd_, SOMAXCONN) < 0) {
+        logging::error(Event::AppError, "Listen failed");
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        logging::error(Event::AppError, "epoll_create1 failed");
+        return false;
     }
 
-    std::cout << "[app] Listening on port " << port_ << "...\n";
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = server_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, server_fd_, &ev) < 0) {
+        logging::error(Event::AppError, "epoll_ctl(server) failed");
+        return false;
+    }
+    ev.data.fd = wake_fd_;
+    if (wake_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) < 0) {
+        logging::error(Event::AppError, "epoll_ctl(wake) failed");
+        return false;
+    }
+
+    // The stats endpoint is optional; failing to open it is not fatal.
+    if (!cfg_.statsSocketPath.empty() && openStatsSocket()) {
+        ev.data.fd = stats_fd_;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stats_fd_, &ev);
+        logging::info(Event::AppStats, cfg_.statsSocketPath);
+    }
+    return true;
+}
+
+bool App::openStatsSocket() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (cfg_.statsSocketPath.size() >= sizeof(addr.sun_path)) {
+        logging::error(Event::AppError, "Stats socket path too long");
+        return false;
+    }
+    std::memcpy(addr.sun_path, cfg_.statsSocketPath.c_str(), cfg_.statsSocketPath.size() + 1);
+
+    stats_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (stats_fd_ < 0) {
+        logging::error(Event::AppError, "Stats socket creation failed");
+        return false;
+    }
+    unlink(addr.sun_path);  // stale socket from a previous run
+    if (bind(stats_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(stats_fd_, 4) < 0) {
+        logging::error(Event::AppErrno, "Stats socket bind failed", std::strerror(errno));
+        close(stats_fd_);
+        stats_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+void App::serveStats() {
+    // Cold path: one snapshot per connection, written and closed immediately.
+    while (true) {
+        int fd = accept4(stats_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) return;
+        std::string body = statsJson();
+        body += '\n';
+        (void)!send(fd, body.data(), body.size(), MSG_NOSIGNAL);
+        close(fd);
+    }
+}
+
+static const char* modeName(ExecMode mode) {
+    return mode == ExecMode::Reactor ? "reactor" : "threaded";
+}
+
+// Actuator names come from the config file and go into JSON verbatim;
+// sanitised like the telemetry device id.
+static std::string jsonName(std::string name) {
+    for (char& c : name) {
+        if (c == '"' || c == '\\' || (unsigned char)c < 0x20) c = '_';
+    }
+    return name;
+}
+
+static uint64_t cpuMs(const rusage& ru) {
+    return uint64_t(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000 +
+           uint64_t(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+}
 
+std::string App::statsJson() const {
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+
+    std::string out = "{\"uptime_ms\":" + std::to_string((util::monotonicNs() - started_ns_) / 1000000) +
+                      ",\"mode\":\"" + modeName(cfg_.execMode) + "\"" +
+                      ",\"process\":{\"cpu_ms\":" + std::to_string(cpuMs(ru)) +
+                      ",\"voluntary_ctxsw\":" + std::to_string(ru.ru_nvcsw) +
+                      ",\"involuntary_ctxsw\":" + std::to_string(ru.ru_nivcsw) + "}" +
+                      ",\"startup_us\":{\"ready\":" + std::to_string(startup_.readyNs / 1000) +
+                      ",\"init\":" + std::to_string(startup_.initNs / 1000) +
+                      ",\"actuators\":" + std::to_string(startup_.actuatorsNs / 1000) +
+                      ",\"listen\":" + std::to_string(startup_.listenNs / 1000) +
+                      ",\"command_log\":" + std::to_string(startup_.commandLogNs / 1000) +
+                      ",\"telemetry\":" + std::to_string(startup_.telemetryNs / 1000) +
+                      ",\"shm\":" + std::to_string(startup_.shmNs / 1000) + "},";
+    metrics::registry().appendJson(out);
+
+    auto queueJson = [](const util::QueueStats& q) {
+        return "{\"pushed\":" + std::to_string(q.pushed) + ",\"overflowed\":" + std::to_string(q.overflowed) +
+               ",\"coalesced\":" + std::to_string(q.coalesced) + ",\"rejected\":" + std::to_string(q.rejected) + "}";
+    };
+    if (actuators_) {
+        out += ",\"steppers\":[";
+        for (const auto& s : actuators_->steppers()) {
+            const StepperController& st = *s.controller;
+            const auto& err = st.stepTimingError();
+            if (&s != &actuators_->steppers().front()) out += ',';
+            out += "{\"name\":\"" + jsonName(s.name) + "\",\"id\":" + std::to_string(s.id) +
+                   ",\"drive\":\"" + name(st.driveMode()) + "\"" +
+                   ",\"setup_us\":" + std::to_string(s.setupNs / 1000) +
+                   ",\"position\":" + std::to_string(st.position()) +
+                   ",\"target\":" + std::to_string(st.target()) +
+                   ",\"queue\":" + queueJson(st.queueStats()) +
+                   ",\"step_timing_error_ns\":{\"p50\":" + std::to_string(err.percentile(50)) +
+                   ",\"p99\":" + std::to_string(err.percentile(99)) + ",\"max\":" + std::to_string(err.max()) + "}}";
+        }
+        out += "],\"servos\":[";
+        for (const auto& s : actuators_->servos()) {
+            const ServoController& sv = *s.controller;
+            if (&s != &actuators_->servos().front()) out += ',';
+            out += "{\"name\":\"" + jsonName(s.name) + "\",\"id\":" + std::to_string(s.id) +
+                   ",\"setup_us\":" + std::to_string(s.setupNs / 1000) +
+                   ",\"setup_writes\":" + std::to_string(sv.pwm().setupWrites()) +
+                   ",\"duty_writes\":" + std::to_string(sv.dutyWrites()) +
+                   ",\"ticks\":" + std::to_string(sv.ticks()) +
+                   ",\"write_errors\":" + std::to_string(sv.writeErrors()) +
+                   ",\"queue\":" + queueJson(sv.queueStats()) + "}";
+        }
+        out += ']';
+    }
+    if (shm_ring_) {
+        out += ",\"shm\":{\"producer_drops\":" + std::to_string(shm_ring_->producerDrops()) + "}";
+    }
+    if (cmd_log_) {
+        out += ",\"command_log\":{\"records\":" + std::to_string(cmd_log_->records()) +
+               ",\"dropped\":" + std::to_string(cmd_log_->dropped()) + "}";
+    }
+    if (telemetry_) {
+        const telemetry::UploaderStats t = telemetry_->stats();
+        out += ",\"telemetry\":{\"queued\":" + std::to_string(t.queued) + ",\"sent\":" + std::to_string(t.sent) +
+               ",\"batches\":" + std::to_string(t.batches) + ",\"wire_bytes\":" + std::to_string(t.wireBytes) +
+               ",\"failures\":" + std::to_string(t.failures) + ",\"spill_bytes\":" + std::to_string(t.spillBytes) +
+               ",\"dropped\":" + std::to_string(t.queueDropped + t.lost + t.spillEvicted) + "}";
+    }
+    if (keypoints_.frames()) {
+        out += ",\"pose\":{\"frames\":" + std::to_string(keypoints_.frames()) +
+               ",\"low_confidence\":" + std::to_string(keypoints_.lowConfidence()) +
+               ",\"pose\":" + std::to_string(keypoints_.pose()) + ",\"angles_deg\":{";
+        for (size_t lane = 0; lane < pose::kJoints; ++lane) {
+            if (lane) out += ',';
+            out += '"';
+            out += pose::name(pose::Joint(lane / 2));
+            out += lane % 2 ? "_r\":" : "_l\":";
+            out += std::to_string(int(keypoints_.angleDeg(lane)));
+        }
+        out += "}}";
+    }
+    out += ",\"analytics\":";
+    workout().appendJson(out);
+    out += '}';
+    return out;
+}
+
+void App::loopThreadFunc() {
+    const bool reactor = cfg_.execMode == ExecMode::Reactor;
+    if (reactor) {
+        StepperTiming placement;
+        placement.cpu = cfg_.reactorCpu;
+        placement.rtPriority = cfg_.reactorPriority;
+        StepScheduler::configureThread(placement, "[app]");
+    }
+
+    epoll_event events[kMaxEvents];
     while (!stop_requested_) {
-        sockaddr_in clientAddr{};
-        socklen_t addrLen = sizeof(clientAddr);
-        client_fd_ = accept(server_fd_, (struct sockaddr*)&clientAddr, &addrLen);
-        if (client_fd_ < 0) {
-            if (stop_requested_) break;
-            std::cerr << "[app] Accept failed\n";
+        int n = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            logging::error(Event::AppErrno, "epoll_wait failed", std::strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_ || fd == timer_fd_) {
+                // Drain the counter; stop_requested_ is checked by the outer loop
+                // and due controllers are polled below.
+                uint64_t ticks;
+                (void)!read(fd, &ticks, sizeof(ticks));
+                continue;
+            }
+            if (fd == server_fd_) {
+                acceptClients();
+                continue;
+            }
+            if (fd == stats_fd_) {
+                serveStats();
+                continue;
+            }
+            Connection* conn = fd < (int)conns_.size() ? conns_[fd].get() : nullptr;
+            if (!conn) continue;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                readClient(*conn);
+            }
+        }
+
+        // Cheap when nothing is due: each poll is a deadline compare or an empty tryPop.
+        if (reactor) pollControllers();
+    }
+
+    closeServer();
+}
+
+void App::acceptClients() {
+    // Edge-triggered listener semantics: drain the accept queue.
+    while (true) {
+        int fd = accept4(server_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                logging::error(Event::AppErrno, "Accept failed", std::strerror(errno));
+            }
+            return;
+        }
+
+        if (fd >= (int)conns_.size()) conns_.resize(fd + 1);
+        conns_[fd] = std::make_unique<Connection>();
+        conns_[fd]->fd = fd;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            logging::error(Event::AppError, "epoll_ctl(client) failed");
+            closeClient(fd);
             continue;
         }
 
-        std::cout << "[app] Client connected\n";
+        logging::info(Event::AppClientConnected, fd);
+    }
+}
 
-        char buffer[2];
-        while (!stop_requested_) {
-            ssize_t bytes = recv(client_fd_, buffer, 1, 0);
-            if (bytes <= 0) {
-                std::cout << "[app] Client disconnected\n";
-                close(client_fd_);
-                client_fd_ = -1;
-                break;
+void App::readClient(Connection& conn) {
+    // Edge-triggered: keep reading until the socket is drained.
+    while (true) {
+        ssize_t bytes = recv(conn.fd, conn.buf.data() + conn.len, conn.buf.size() - conn.len, 0);
+        if (bytes > 0) {
+            conn.len += static_cast<size_t>(bytes);
+            if (!parseCommands(conn, util::monotonicNs())) {
+                metrics::registry().add(metrics::Counter::ProtocolErrors);
+                logging::warn(Event::AppProtocolError, conn.fd);
+                closeClient(conn.fd);
+                return;
             }
+            continue;
+        }
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        logging::info(Event::AppClientDisconnected, conn.fd);
+        closeClient(conn.fd);
+        return;
+    }
+}
+
+bool App::parseCommands(Connection& conn, uint64_t rxNs) {
+    const uint8_t* data = conn.buf.data();
+    size_t len = conn.len;
+    size_t used = 0;
+
+    if (conn.mode == WireMode::Unknown) {
+        if (data[0] == proto::kNegotiateBinary) {
+            conn.mode = WireMode::Binary;
+            used = 1;
+            logging::info(Event::AppFramed, conn.fd, int(proto::kVersion));
+        } else {
+            conn.mode = WireMode::Legacy;
+        }
+    }
 
-            int cmd = buffer[0] - '0';
-            switch (cmd) {
-                case 34:
-                case 28:
-                    if (stepper_) {
-                        stepper_->pushCommand(cmd);
-                    } else {
-                        std::cerr << "[app] Stepper not ready; drop cmd " << cmd << "\n";
-                    }
-                    break;
-                case 2:
-                case 3:
-                case 4:
-                    if (servo_) {
-                        servo_->pushCommand(cmd);
-                    } else {
-                        std::cerr << "[app] Servo not ready; drop cmd " << cmd << "\n";
-                    }
-                    break;
-                default:
-                    std::cerr << "[app] Unknown pose cmd " << cmd << "\n";
-                    break;
+    if (conn.mode == WireMode::Legacy) {
+        for (; used < len; ++used) {
+            proto::Command cmd;
+            if (!proto::decodeLegacy(static_cast<char>(data[used]), cmd)) {
+                metrics::registry().add(metrics::Counter::Unknown);
+                logging::warn(Event::AppUnknownPose, int(data[used]) - '0');
+                continue;
             }
+            cmd.rxNs = rxNs;
+            dispatchCommand(cmd);
         }
+    } else {
+        auto r = proto::parseFrames(data + used, len - used, [&](const proto::FrameView& frame) {
+            if (!acceptFrame(conn.seq, frame, rxNs)) return;
+            dispatchFrame(frame, rxNs, proto::Source::TcpFramed);
+        });
+        if (!r.ok) return false;
+        used += r.used;
+        // A frame that cannot fit the receive buffer would never complete.
+        if (used == 0 && len == conn.buf.size()) return false;
     }
 
-    closeServer();
+    // Keep any trailing partial frame for the next read.
+    if (used < len) {
+        std::memmove(conn.buf.data(), conn.buf.data() + used, len - used);
+    }
+    conn.len = len - used;
+    return true;
+}
+
+bool App::acceptFrame(SeqState& seqState, const proto::FrameView& frame, uint64_t rxNs) const {
+    auto& m = metrics::registry();
+
+    // Sequence numbers wrap; anything not strictly newer is a duplicate or reordered.
+    uint32_t seq = frame.seq();
+    if (seqState.have && static_cast<int32_t>(seq - seqState.last) <= 0) {
+        m.add(metrics::Counter::OutOfOrder);
+        return false;
+    }
+    seqState.have = true;
+    seqState.last = seq;
+
+    uint64_t sent = frame.sentNs();
+    if (sent == 0 || sent > rxNs) return true;  // sender clock unknown or not comparable
+
+    uint64_t age = rxNs - sent;
+    m.record(metrics::Stage::Ingress, age);
+
+    if (cfg_.maxFrameAgeMs != 0 && age > uint64_t(cfg_.maxFrameAgeMs) * 1000000ull) {
+        m.add(metrics::Counter::Stale);
+        return false;
+    }
+    return true;
+}
+
+void App::dispatchFrame(const proto::FrameView& frame, uint64_t rxNs, proto::Source source) {
+    if (frame.op() == proto::Op::Keypoints) {
+        classifyKeypoints(frame, rxNs, source);
+        return;
+    }
+    proto::Command cmd;
+    cmd.op = frame.op();
+    cmd.actuator = frame.actuator();
+    cmd.arg = frame.arg();
+    cmd.seq = frame.seq();
+    cmd.sentNs = frame.sentNs();
+    cmd.rxNs = rxNs;
+    cmd.source = source;
+    dispatchCommand(cmd);
+}
+
+void App::classifyKeypoints(const proto::FrameView& frame, uint64_t rxNs, proto::Source source) {
+    constexpr size_t kMaxFrames = (kRecvBufSize - proto::kHeaderSize) / pose::kFrameBytes;
+    const size_t count = frame.payloadLen() / pose::kFrameBytes;
+    if (source != proto::Source::TcpFramed || count == 0 || count > kMaxFrames ||
+        frame.payloadLen() % pose::kFrameBytes != 0) {
+        metrics::registry().add(metrics::Counter::Unknown);
+        logging::warn(Event::AppBadKeypoints, frame.payloadLen());
+        return;
+    }
+
+    // The derived commands inherit the frame's stamps, so latency accounting
+    // and the command log see them as if the sender had classified them.
+    proto::Command out[kMaxFrames * pose::KeypointClassifier::kMaxCommandsPerFrame];
+    size_t n = keypoints_.classify(frame.payload(), count, out);
+    for (size_t i = 0; i < n; ++i) {
+        out[i].actuator = frame.actuator();
+        out[i].seq = frame.seq();
+        out[i].sentNs = frame.sentNs();
+        out[i].rxNs = rxNs;
+        out[i].source = source;
+        dispatchCommand(out[i]);
+    }
+}
+
+bool App::inject(proto::Command cmd) {
+    cmd.rxNs = util::monotonicNs();
+    cmd.sentNs = 0;
+    cmd.source = proto::Source::Replay;
+    bool ok = dispatchCommand(cmd);
+    if (cfg_.execMode == ExecMode::Reactor) pokeReactor();
+    return ok;
+}
+
+void App::pokeReactor() {
+    // The controllers only move when the reactor polls them.
+    uint64_t one = 1;
+    (void)!write(wake_fd_, &one, sizeof(one));
+}
+
+bool App::dispatchCommand(const proto::Command& cmd) {
+    if (cmd_log_) cmd_log_->append(cmd);
+    if (telemetry_) {
+        telemetry::Record rec;
+        rec.tsNs = cmd.rxNs;
+        rec.kind = telemetry::Kind::Command;
+        rec.actuator = cmd.actuator;
+        rec.command = {cmd.arg, uint8_t(cmd.op), uint8_t(cmd.source),
+                       cmd.sentNs && cmd.rxNs > cmd.sentNs ? cmd.rxNs - cmd.sentNs : 0};
+        telemetry_->push(rec);
+    }
+    switch (cmd.source) {
+        case proto::Source::Shm: analytics_[kShmShard].onCommand(cmd); break;
+        case proto::Source::Replay: analytics_[kReplayShard].onCommand(cmd); break;
+        default: analytics_[kSocketShard].onCommand(cmd); break;
+    }
+
+    if (!actuators_) {
+        metrics::registry().add(metrics::Counter::NotReady);
+        return true;
+    }
+    return actuators_->dispatch(cmd);
+}
+
+void App::printStats() const {
+    std::string text;
+    metrics::registry().appendText(text);
+    logging::info(Event::AppReportHeader, "Command path stats");
+    logging::lines(logging::Level::Info, text);
+
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    double secs = double(util::monotonicNs() - started_ns_) / 1e9;
+    logging::info(Event::AppExecMode, modeName(cfg_.execMode), cpuMs(ru), secs,
+                  double(ru.ru_nvcsw + ru.ru_nivcsw) / secs);
+
+    if (actuators_) {
+        for (const auto& s : actuators_->steppers()) {
+            const StepperController& st = *s.controller;
+            printQueueStats(s.name, st.queueStats());
+            const auto& err = st.stepTimingError();
+            if (err.count()) {
+                logging::info(Event::AppTimingError, s.name, err.percentile(50) / 1000, err.percentile(99) / 1000,
+                              err.max() / 1000, err.count());
+            }
+            const auto& react = st.reactionLatency();
+            if (react.count()) {
+                logging::info(Event::AppReaction, s.name, react.percentile(50) / 1000, react.percentile(99) / 1000,
+                              react.max() / 1000, st.position());
+            }
+        }
+        for (const auto& s : actuators_->servos()) {
+            const ServoController& sv = *s.controller;
+            printQueueStats(s.name, sv.queueStats());
+            logging::info(Event::AppServoWrites, s.name, sv.dutyWrites(), sv.ticks(), sv.writeErrors());
+        }
+    }
+    if (shm_ring_) {
+        logging::info(Event::AppShmDrops, shm_ring_->producerDrops());
+    }
+    if (cmd_log_) {
+        logging::info(Event::AppCommandLog, cmd_log_->records(), cmd_log_->dropped());
+    }
+    logging::info(Event::AppLogStats, logging::written(), logging::dropped());
+
+    std::string summary;
+    workout().appendText(summary, "  ");
+    logging::info(Event::AppReportHeader, "Workout");
+    logging::lines(logging::Level::Info, summary);
+}
+
+analytics::WorkoutAnalyzer App::workout() const {
+    analytics::WorkoutAnalyzer merged(cfg_.analytics);
+    analytics::WorkoutAnalyzer shard(cfg_.analytics);
+    for (const auto& a : analytics_) {
+        a.snapshot(shard);
+        merged.merge(shard);
+    }
+    return merged;
+}
+
+// Uploader thread: one sample per actuator. Everything read here is atomic.
+void App::sampleTelemetry(telemetry::Uploader& up) const {
+    if (!actuators_) return;
+    const uint64_t now = util::monotonicNs();
+    auto lost = [](const util::QueueStats& q) { return q.overflowed + q.coalesced + q.rejected; };
+    for (const auto& s : actuators_->steppers()) {
+        const StepperController& st = *s.controller;
+        const util::QueueStats q = st.queueStats();
+        telemetry::Record rec;
+        rec.tsNs = now;
+        rec.kind = telemetry::Kind::Stepper;
+        rec.actuator = s.id;
+        rec.stepper = {st.position(), q.pushed, lost(q), st.stepTimingError().percentile(99)};
+        up.push(rec);
+    }
+    for (const auto& s : actuators_->servos()) {
+        const ServoController& sv = *s.controller;
+        const util::QueueStats q = sv.queueStats();
+        telemetry::Record rec;
+        rec.tsNs = now;
+        rec.kind = telemetry::Kind::Servo;
+        rec.actuator = s.id;
+        rec.servo = {sv.dutyWrites(), sv.writeErrors(), q.pushed, lost(q)};
+        up.push(rec);
+    }
+}
+
+void App::closeClient(int fd) {
+    if (epoll_fd_ != -1) epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    if (fd < (int)conns_.size()) conns_[fd].reset();
+}
+
+bool App::openTimer() {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    ev.data.fd = timer_fd_;
+    if (timer_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &ev) < 0) {
+        logging::error(Event::AppErrno, "timerfd setup failed", std::strerror(errno));
+        return false;
+    }
+    timer_armed_ns_ = 0;
+    return true;
+}
+
+// Arm fd for an absolute CLOCK_MONOTONIC deadline (0 disarms), skipping the
+// syscall when it is already armed for that deadline.
+static void armTimer(int fd, uint64_t deadlineNs, uint64_t& armedNs) {
+    if (deadlineNs == armedNs) return;
+    itimerspec its{};
+    its.it_value.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ull);
+    its.it_value.tv_nsec = static_cast<long>(deadlineNs % 1000000000ull);
+    timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, nullptr);
+    armedNs = deadlineNs;
+}
+
+void App::pollControllers() {
+    uint64_t now = util::monotonicNs();
+    if (actuators_) armTimer(timer_fd_, actuators_->poll(now), timer_armed_ns_);
 }
 
 void App::closeServer() {
-    if (client_fd_ != -1) {
-        close(client_fd_);
-        client_fd_ = -1;
+    for (auto& conn : conns_) {
+        if (conn) closeClient(conn->fd);
     }
+    conns_.clear();
     if (server_fd_ != -1) {
         close(server_fd_);
         server_fd_ = -1;
     }
+    if (stats_fd_ != -1) {
+        close(stats_fd_);
+        stats_fd_ = -1;
+        unlink(cfg_.statsSocketPath.c_str());
+    }
+    if (timer_fd_ != -1) {
+        close(timer_fd_);
+        timer_fd_ = -1;
+    }
+    if (epoll_fd_ != -1) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
 }
@@ -0,0 +1,39 @@
+#include "app/Replay.hpp"
+#include "util/Clock.hpp"
+#include <cerrno>
+#include <time.h>
+
+static void sleepUntil(uint64_t deadlineNs) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs / 1000000000ull);
+    ts.tv_nsec = static_cast<long>(deadlineNs % 1000000000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+ReplayResult replayLog(const cmdlog::Reader& log, App& app, double speed, const std::atomic<bool>& cancel) {
+    ReplayResult res;
+    const uint64_t start = util::monotonicNs();
+    uint64_t firstRx = 0;
+
+    log.forEach([&](const cmdlog::Record& rec) {
+        if (cancel.load(std::memory_order_relaxed)) return;
+        if (speed > 0.0) {
+            if (res.commands == 0) firstRx = rec.rxNs;
+            // Records from two ingress threads can be slightly out of rx order.
+            uint64_t offset = rec.rxNs > firstRx ? rec.rxNs - firstRx : 0;
+            uint64_t due = start + static_cast<uint64_t>(double(offset) / speed);
+            uint64_t now = util::monotonicNs();
+            if (now < due) {
+                sleepUntil(due);
+            } else if (now - due > res.maxLagNs) {
+                res.maxLagNs = now - due;
+            }
+        }
+        app.inject(cmdlog::Reader::toCommand(rec));
+        ++res.commands;
+    });
+
+    res.elapsedNs = util::monotonicNs() - start;
+    return res;
+}
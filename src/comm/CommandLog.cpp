@@ -0,0 +1,169 @@
+#include "comm/CommandLog.hpp"
+#include "util/Clock.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace cmdlog {
+
+/* ---------------- Writer ---------------- */
+
+Writer::Writer(std::string path, uint64_t capacity)
+    : path_(std::move(path)), capacity_(capacity) {
+    if (capacity_ == 0) {
+        throw std::invalid_argument("[cmdlog] Capacity must be at least one record");
+    }
+}
+
+Writer::~Writer() {
+    close();
+}
+
+void Writer::open() {
+    if (hdr_) return;
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("[cmdlog] Failed to open " + path_ + ": " + std::strerror(errno));
+    }
+    mapSize_ = kRecordsOffset + size_t(capacity_) * sizeof(Record);
+
+    // Reserve the blocks up front so a full disk fails here rather than as
+    // SIGBUS on a store into the mapping mid-session.
+    int rc = posix_fallocate(fd_, 0, static_cast<off_t>(mapSize_));
+    if (rc == EOPNOTSUPP || rc == EINVAL) {
+        rc = ftruncate(fd_, static_cast<off_t>(mapSize_)) < 0 ? errno : 0;
+    }
+    if (rc != 0) {
+        close();
+        throw std::runtime_error("[cmdlog] Failed to allocate " + path_ + ": " + std::strerror(rc));
+    }
+
+    void* p = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (p == MAP_FAILED) {
+        close();
+        throw std::runtime_error("[cmdlog] Failed to map " + path_ + ": " + std::strerror(errno));
+    }
+
+    timespec real{};
+    clock_gettime(CLOCK_REALTIME, &real);
+    hdr_ = new (p) LogHeader{};
+    hdr_->version = kLayoutVersion;
+    hdr_->recordSize = sizeof(Record);
+    hdr_->capacity = capacity_;
+    hdr_->startMonoNs = util::monotonicNs();
+    hdr_->startRealNs = uint64_t(real.tv_sec) * 1000000000ull + uint64_t(real.tv_nsec);
+    hdr_->magic = kMagic;
+    records_ = reinterpret_cast<Record*>(static_cast<uint8_t*>(p) + kRecordsOffset);
+}
+
+void Writer::close() {
+    if (hdr_) {
+        uint64_t used = records();
+        munmap(hdr_, mapSize_);
+        hdr_ = nullptr;
+        records_ = nullptr;
+        // Give back the unused tail of the preallocation.
+        (void)!ftruncate(fd_, static_cast<off_t>(kRecordsOffset + used * sizeof(Record)));
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool Writer::append(const proto::Command& cmd) noexcept {
+    uint64_t i = hdr_->next.fetch_add(1, std::memory_order_relaxed);
+    if (i >= capacity_) {
+        hdr_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Record& r = records_[i];
+    r.rxNs = cmd.rxNs;
+    r.sentNs = cmd.sentNs;
+    r.arg = cmd.arg;
+    r.seq = cmd.seq;
+    r.op = static_cast<uint8_t>(cmd.op);
+    r.actuator = cmd.actuator;
+    r.source = static_cast<uint8_t>(cmd.source);
+    std::atomic_ref<uint8_t>(r.committed).store(1, std::memory_order_release);
+    return true;
+}
+
+uint64_t Writer::records() const {
+    return hdr_ ? std::min(hdr_->next.load(std::memory_order_relaxed), capacity_) : 0;
+}
+
+uint64_t Writer::dropped() const {
+    return hdr_ ? hdr_->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+/* ---------------- Reader ---------------- */
+
+Reader::Reader(std::string path) : path_(std::move(path)) {}
+
+Reader::~Reader() {
+    close();
+}
+
+void Reader::open() {
+    if (hdr_) return;
+
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("[cmdlog] Failed to open " + path_ + ": " + std::strerror(errno));
+    }
+    struct stat st{};
+    if (fstat(fd_, &st) < 0 || size_t(st.st_size) < kRecordsOffset) {
+        close();
+        throw std::runtime_error("[cmdlog] " + path_ + " is not a command log");
+    }
+    mapSize_ = size_t(st.st_size);
+    void* p = mmap(nullptr, mapSize_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        close();
+        throw std::runtime_error("[cmdlog] Failed to map " + path_ + ": " + std::strerror(errno));
+    }
+    hdr_ = static_cast<const LogHeader*>(p);
+    if (hdr_->magic != kMagic || hdr_->version != kLayoutVersion || hdr_->recordSize != sizeof(Record)) {
+        close();
+        throw std::runtime_error("[cmdlog] " + path_ + " has an unsupported layout");
+    }
+    records_ = reinterpret_cast<const Record*>(static_cast<const uint8_t*>(p) + kRecordsOffset);
+    size_t inFile = (mapSize_ - kRecordsOffset) / sizeof(Record);
+    count_ = size_t(std::min<uint64_t>({hdr_->next.load(std::memory_order_acquire), hdr_->capacity, inFile}));
+}
+
+void Reader::close() {
+    if (hdr_) {
+        munmap(const_cast<LogHeader*>(hdr_), mapSize_);
+        hdr_ = nullptr;
+        records_ = nullptr;
+        count_ = 0;
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+proto::Command Reader::toCommand(const Record& r) {
+    proto::Command cmd;
+    cmd.op = static_cast<proto::Op>(r.op);
+    cmd.actuator = r.actuator;
+    cmd.arg = r.arg;
+    cmd.seq = r.seq;
+    cmd.sentNs = r.sentNs;
+    cmd.rxNs = r.rxNs;
+    cmd.source = static_cast<proto::Source>(r.source);
+    return cmd;
+}
+
+} // namespace cmdlog
@@ -0,0 +1,114 @@
+#include "comm/ShmRing.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace shm {
+
+int futexWait(std::atomic<uint32_t>* word, uint32_t expected, int timeoutMs) {
+    timespec ts{};
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = long(timeoutMs % 1000) * 1000000L;
+    return static_cast<int>(syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT,
+                                    expected, timeoutMs >= 0 ? &ts : nullptr, nullptr, 0));
+}
+
+int futexWake(std::atomic<uint32_t>* word) {
+    return static_cast<int>(syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE,
+                                    1, nullptr, nullptr, 0));
+}
+
+RingReader::RingReader(std::string path, uint32_t capacity)
+    : path_(std::move(path)), capacity_(capacity) {
+    if (capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0) {
+        throw std::invalid_argument("[shm] Ring capacity must be a power of two");
+    }
+}
+
+RingReader::~RingReader() {
+    close();
+}
+
+void RingReader::open() {
+    if (hdr_) return;
+
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0660);
+    if (fd_ < 0) {
+        throw std::runtime_error("[shm] Failed to open " + path_ + ": " + std::strerror(errno));
+    }
+    mapSize_ = mappingSize(capacity_);
+    if (ftruncate(fd_, static_cast<off_t>(mapSize_)) < 0) {
+        close();
+        throw std::runtime_error("[shm] Failed to size " + path_ + ": " + std::strerror(errno));
+    }
+    void* p = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (p == MAP_FAILED) {
+        close();
+        throw std::runtime_error("[shm] Failed to map " + path_ + ": " + std::strerror(errno));
+    }
+
+    // The consumer owns the layout: (re)initialise it on every start so a
+    // producer left over from a previous run cannot hand us stale frames.
+    // magic is written last so attaching producers never see a half-built header.
+    hdr_ = new (p) RingHeader{};
+    hdr_->version = kLayoutVersion;
+    hdr_->capacity = capacity_;
+    hdr_->slotSize = kSlotSize;
+    std::atomic_thread_fence(std::memory_order_release);
+    hdr_->magic = kMagic;
+}
+
+void RingReader::close() {
+    if (hdr_) {
+        munmap(hdr_, mapSize_);
+        hdr_ = nullptr;
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool RingReader::empty() const {
+    return hdr_->head.load(std::memory_order_acquire) == hdr_->tail.load(std::memory_order_relaxed);
+}
+
+void RingReader::waitForData(int spinIters, int timeoutMs, const std::atomic<bool>& cancel) {
+    for (int i = 0; i < spinIters; ++i) {
+        if (!empty()) return;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    uint32_t seen = hdr_->futexWord.load(std::memory_order_acquire);
+    // A wake() that `seen` missed has not run yet and will change the word.
+    if (cancel.load(std::memory_order_acquire)) return;
+    hdr_->consumerWaiting.store(1, std::memory_order_seq_cst);
+    // Re-check after announcing so a publish that raced the store is not missed.
+    if (hdr_->head.load(std::memory_order_seq_cst) == hdr_->tail.load(std::memory_order_relaxed)) {
+        futexWait(&hdr_->futexWord, seen, timeoutMs);
+    }
+    hdr_->consumerWaiting.store(0, std::memory_order_relaxed);
+}
+
+void RingReader::wake() {
+    if (!hdr_) return;
+    hdr_->futexWord.fetch_add(1, std::memory_order_release);
+    futexWake(&hdr_->futexWord);
+}
+
+uint64_t RingReader::producerDrops() const {
+    return hdr_ ? hdr_->producerDrops.load(std::memory_order_relaxed) : 0;
+}
+
+} // namespace shm
@@ -0,0 +1,606 @@
+#include "comm/TelemetryUploader.hpp"
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef WT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace telemetry {
+
+namespace {
+
+constexpr size_t kRecordJsonBytes = 160;  // upper bound for one NDJSON line
+constexpr size_t kSpillPerCycle = 8;      // resend at most this many files between queue drains
+constexpr const char* kSpillSuffix = ".ndjson";
+constexpr const char* kSpillSuffixGz = ".ndjson.gz";
+
+uint64_t realtimeNs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000ull + uint64_t(ts.tv_nsec);
+}
+
+bool accepted(int status) {
+    return status >= 200 && status < 300;
+}
+
+// A 4xx other than timeout/throttling means the collector will never take this body.
+bool refused(int status) {
+    return status >= 400 && status < 500 && status != 408 && status != 429;
+}
+
+#ifdef WT_HAVE_ZLIB
+// deflate's allocator, counting into Uploader::zlibBytes_ so memoryBytes()
+// reports what the compressor really holds. Each block carries its size.
+constexpr size_t kZHeader = alignof(std::max_align_t);
+
+voidpf zAlloc(voidpf opaque, uInt items, uInt size) {
+    const size_t bytes = size_t(items) * size;
+    auto* block = static_cast<char*>(std::malloc(kZHeader + bytes));
+    if (!block) return Z_NULL;
+    *reinterpret_cast<size_t*>(block) = bytes;
+    static_cast<std::atomic<size_t>*>(opaque)->fetch_add(bytes, std::memory_order_relaxed);
+    return block + kZHeader;
+}
+
+void zFree(voidpf opaque, voidpf address) {
+    char* block = static_cast<char*>(address) - kZHeader;
+    static_cast<std::atomic<size_t>*>(opaque)->fetch_sub(*reinterpret_cast<size_t*>(block),
+                                                         std::memory_order_relaxed);
+    std::free(block);
+}
+#endif
+
+const char* kindName(Kind k) {
+    switch (k) {
+        case Kind::Command: return "command";
+        case Kind::Stepper: return "stepper";
+        case Kind::Servo: return "servo";
+        case Kind::Session: return "session";
+    }
+    return "?";
+}
+
+} // namespace
+
+Uploader::Uploader(UploaderConfig cfg)
+    : cfg_(std::move(cfg)), queue_(cfg_.queueCapacity, util::OverflowPolicy::Reject) {
+    constexpr std::string_view kScheme = "http://";
+    std::string_view url = cfg_.url;
+    if (url.substr(0, kScheme.size()) != kScheme) {
+        throw std::invalid_argument("[telemetry] " + cfg_.url + ": only http:// URLs are supported");
+    }
+    url.remove_prefix(kScheme.size());
+    size_t slash = url.find('/');
+    std::string_view authority = url.substr(0, slash);
+    path_ = slash == std::string_view::npos ? "/" : std::string(url.substr(slash));
+    // An IPv6 literal is bracketed, since its colons would read as the port.
+    size_t colon = authority.rfind(':');
+    if (!authority.empty() && authority.front() == '[') {
+        size_t close = authority.find(']');
+        if (close == std::string_view::npos || (close + 1 < authority.size() && authority[close + 1] != ':')) {
+            throw std::invalid_argument("[telemetry] " + cfg_.url + ": expected http://[addr][:port]/path");
+        }
+        host_ = std::string(authority.substr(1, close - 1));
+        colon = close + 1 < authority.size() ? close + 1 : std::string_view::npos;
+    } else {
+        host_ = std::string(authority.substr(0, colon));
+    }
+    port_ = colon == std::string_view::npos ? "80" : std::string(authority.substr(colon + 1));
+    if (host_.empty() || port_.empty() || port_.find_first_not_of("0123456789") != std::string::npos) {
+        throw std::invalid_argument("[telemetry] " + cfg_.url + ": expected http://host[:port]/path");
+    }
+    if (cfg_.maxBatchRecords == 0) cfg_.maxBatchRecords = 1;
+
+    if (cfg_.deviceId.empty()) {
+        char name[256] = {};
+        gethostname(name, sizeof(name) - 1);
+        cfg_.deviceId = name;
+    }
+    // It goes into JSON verbatim.
+    for (char& c : cfg_.deviceId) {
+        if (c == '"' || c == '\\' || (unsigned char)c < 0x20) c = '_';
+    }
+
+#ifdef WT_HAVE_ZLIB
+    auto* zs = new z_stream{};
+    zs->zalloc = zAlloc;
+    zs->zfree = zFree;
+    zs->opaque = &zlibBytes_;
+    if (deflateInit2(zs, cfg_.compressLevel, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        delete zs;
+        throw std::runtime_error("[telemetry] deflateInit2 failed");
+    }
+    zstream_ = zs;
+    gzip_ = true;
+#endif
+}
+
+Uploader::~Uploader() {
+    stop();
+#ifdef WT_HAVE_ZLIB
+    if (zstream_) {
+        auto* zs = static_cast<z_stream*>(zstream_);
+        deflateEnd(zs);
+        delete zs;
+    }
+#endif
+}
+
+void Uploader::start() {
+    if (running_.load()) return;
+    if (!cfg_.spillDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(cfg_.spillDir, ec);
+        if (ec) throw std::runtime_error("[telemetry] Cannot create " + cfg_.spillDir + ": " + ec.message());
+        scanSpill();
+    }
+    batch_.reserve(cfg_.maxBatchRecords);
+    text_.reserve(cfg_.maxBatchRecords * kRecordJsonBytes);
+    noteBuffers();
+    realOffsetNs_ = realtimeNs() - util::monotonicNs();
+    backoffMs_ = 0;
+    retryAtNs_ = 0;
+    stopping_ = false;
+    running_ = true;
+    thread_ = std::thread(&Uploader::run, this);
+}
+
+void Uploader::stop() {
+    if (!running_.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+UploaderStats Uploader::stats() const {
+    util::QueueStats q = queue_.stats();
+    UploaderStats s;
+    s.queued = q.pushed;
+    s.queueDropped = q.rejected;
+    s.sent = sent_.load(std::memory_order_relaxed);
+    s.batches = batches_.load(std::memory_order_relaxed);
+    s.rawBytes = rawBytes_.load(std::memory_order_relaxed);
+    s.wireBytes = wireBytes_.load(std::memory_order_relaxed);
+    s.failures = failures_.load(std::memory_order_relaxed);
+    s.spilled = spilled_.load(std::memory_order_relaxed);
+    s.spillEvicted = spillEvicted_.load(std::memory_order_relaxed);
+    s.lost = lost_.load(std::memory_order_relaxed);
+    s.spillBytes = spillBytes_.load(std::memory_order_relaxed);
+    return s;
+}
+
+size_t Uploader::memoryBytes() const {
+    size_t zlib = zlibBytes_.load(std::memory_order_relaxed);
+#ifdef WT_HAVE_ZLIB
+    if (zstream_) zlib += sizeof(z_stream);
+#endif
+    return queue_.memoryBytes() + bufferBytes_.load(std::memory_order_relaxed) + zlib;
+}
+
+void Uploader::noteBuffers() {
+    bufferBytes_.store(batch_.capacity() * sizeof(Record) + text_.capacity() + body_.capacity() +
+                           spillBuf_.capacity() + addrs_.capacity() * sizeof(Address),
+                       std::memory_order_relaxed);
+}
+
+uint64_t Uploader::threadCpuNs() const {
+    return cpuNs_.load(std::memory_order_relaxed);
+}
+
+void Uploader::run() {
+    const uint64_t flushNs = uint64_t(cfg_.flushIntervalMs) * 1000000;
+    const uint64_t sampleNs = uint64_t(cfg_.sampleIntervalMs) * 1000000;
+    // Between flushes, look at the queue often enough that it cannot fill
+    // up at a few thousand records per second.
+    const uint64_t pollNs = std::max<uint64_t>(flushNs / 4, 1000000);
+
+    uint64_t now = util::monotonicNs();
+    uint64_t nextFlush = now + flushNs;
+    uint64_t nextSample = now + sampleNs;
+    for (;;) {
+        uint64_t until = std::min({nextFlush, nextSample, now + pollNs});
+        if (!spillFiles_.empty() && retryAtNs_ > now) until = std::min(until, retryAtNs_);
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait_for(lock, std::chrono::nanoseconds(until > now ? until - now : 0),
+                           [this] { return stopping_; });
+            if (stopping_) break;
+        }
+        now = util::monotonicNs();
+        if (sampler_ && now >= nextSample) {
+            sampler_(*this);
+            nextSample = now + sampleNs;
+        }
+        bool due = now >= nextFlush;
+        shipQueued(now, due);
+        if (due) nextFlush = now + flushNs;
+        if (!spillFiles_.empty() && now >= retryAtNs_) drainSpill(now);
+
+        timespec cpu;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+        cpuNs_.store(uint64_t(cpu.tv_sec) * 1000000000ull + uint64_t(cpu.tv_nsec), std::memory_order_relaxed);
+    }
+
+    // Final flush: one attempt, or straight to the spill directory while
+    // backing off, so stop() does not wait out a collector known to be down.
+    shipQueued(util::monotonicNs(), true);
+    timespec cpu;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    cpuNs_.store(uint64_t(cpu.tv_sec) * 1000000000ull + uint64_t(cpu.tv_nsec), std::memory_order_relaxed);
+}
+
+void Uploader::shipQueued(uint64_t nowNs, bool force) {
+    for (;;) {
+        Record rec;
+        while (batch_.size() < cfg_.maxBatchRecords && queue_.tryPop(rec)) batch_.push_back(rec);
+        if (batch_.empty()) return;
+        if (batch_.size() < cfg_.maxBatchRecords && !force) return;  // keep filling
+
+        encode(batch_.data(), batch_.size());
+        const uint64_t records = batch_.size();
+        batch_.clear();
+        const bool gzip = compress();
+        noteBuffers();
+        deliver(body_, gzip, records, text_.size(), nowNs);
+    }
+}
+
+void Uploader::encode(const Record* recs, size_t n) {
+    text_.clear();
+    char line[kRecordJsonBytes * 2];
+    int len = std::snprintf(line, sizeof(line), "{\"device\":\"%s\",\"batch\":%llu,\"records\":%zu}\n",
+                            cfg_.deviceId.c_str(), (unsigned long long)batchSeq_++, n);
+    text_.append(line, size_t(std::clamp(len, 0, int(sizeof(line) - 1))));
+
+    for (size_t i = 0; i < n; ++i) {
+        const Record& r = recs[i];
+        const unsigned long long tMs = (r.tsNs + realOffsetNs_) / 1000000;
+        switch (r.kind) {
+            case Kind::Command:
+                len = std::snprintf(line, sizeof(line),
+                                    "{\"t_ms\":%llu,\"kind\":\"%s\",\"id\":%u,\"op\":%u,\"arg\":%d,\"src\":%u,"
+                                    "\"age_us\":%llu}\n",
+                                    tMs, kindName(r.kind), r.actuator, r.command.op, r.command.arg,
+                                    r.command.source, (unsigned long long)(r.command.ageNs / 1000));
+                break;
+            case Kind::Stepper:
+                len = std::snprintf(line, sizeof(line),
+                                    "{\"t_ms\":%llu,\"kind\":\"%s\",\"id\":%u,\"position\":%lld,\"pushed\":%llu,"
+                                    "\"lost\":%llu,\"timing_p99_us\":%llu}\n",
+                                    tMs, kindName(r.kind), r.actuator, (long long)r.stepper.position,
+                                    (unsigned long long)r.stepper.pushed, (unsigned long long)r.stepper.lost,
+                                    (unsigned long long)(r.stepper.timingP99Ns / 1000));
+                break;
+            case Kind::Servo:
+                len = std::snprintf(line, sizeof(line),
+                                    "{\"t_ms\":%llu,\"kind\":\"%s\",\"id\":%u,\"duty_writes\":%llu,"
+                                    "\"write_errors\":%llu,\"pushed\":%llu,\"lost\":%llu}\n",
+                                    tMs, kindName(r.kind), r.actuator, (unsigned long long)r.servo.dutyWrites,
+                                    (unsigned long long)r.servo.writeErrors, (unsigned long long)r.servo.pushed,
+                                    (unsigned long long)r.servo.lost);
+                break;
+            case Kind::Session:
+                len = std::snprintf(line, sizeof(line),
+                                    "{\"t_ms\":%llu,\"kind\":\"%s\",\"reps\":%u,\"partials\":%u,\"sets\":%u,"
+                                    "\"lateral_shifts\":%u,\"tut_ms\":%llu,\"duration_ms\":%llu}\n",
+                                    tMs, kindName(r.kind), r.session.reps, r.session.partials, r.session.sets,
+                                    r.session.lateralShifts, (unsigned long long)(r.session.tutNs / 1000000),
+                                    (unsigned long long)(r.session.durationNs / 1000000));
+                break;
+            default:
+                len = 0;
+                break;
+        }
+        text_.append(line, size_t(std::clamp(len, 0, int(sizeof(line) - 1))));
+    }
+}
+
+bool Uploader::compress() {
+#ifdef WT_HAVE_ZLIB
+    auto* zs = static_cast<z_stream*>(zstream_);
+    deflateReset(zs);
+    body_.resize(deflateBound(zs, uLong(text_.size())));
+    zs->next_in = reinterpret_cast<Bytef*>(text_.data());
+    zs->avail_in = uInt(text_.size());
+    zs->next_out = body_.data();
+    zs->avail_out = uInt(body_.size());
+    if (deflate(zs, Z_FINISH) != Z_STREAM_END) {
+        // deflateBound() makes this unreachable; fall back to sending it plain.
+        body_.assign(text_.begin(), text_.end());
+        return false;
+    }
+    body_.resize(zs->total_out);
+    return true;
+#else
+    body_.assign(text_.begin(), text_.end());
+    return false;
+#endif
+}
+
+void Uploader::deliver(const std::vector<uint8_t>& body, bool gzip, uint64_t records, uint64_t rawBytes,
+                       uint64_t nowNs) {
+    if (nowNs < retryAtNs_) {  // backing off: straight to disk
+        spill(body, gzip, records);
+        return;
+    }
+    int status = post(body, gzip);
+    if (accepted(status)) {
+        if (backoffMs_ != 0) {
+            logging::info(logging::Event::TelemetryRecovered, cfg_.url, spillFiles_.size());
+        }
+        backoffMs_ = 0;
+        retryAtNs_ = 0;
+        sent_.fetch_add(records, std::memory_order_relaxed);
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        rawBytes_.fetch_add(rawBytes, std::memory_order_relaxed);
+        wireBytes_.fetch_add(body.size(), std::memory_order_relaxed);
+        return;
+    }
+    failures_.fetch_add(1, std::memory_order_relaxed);
+    if (refused(status)) {
+        logging::warn(logging::Event::TelemetryRefused, cfg_.url, status, records);
+        lost_.fetch_add(records, std::memory_order_relaxed);
+        return;
+    }
+    failed(nowNs, status);
+    spill(body, gzip, records);
+}
+
+void Uploader::drainSpill(uint64_t nowNs) {
+    for (size_t i = 0; i < kSpillPerCycle && !spillFiles_.empty() && nowNs >= retryAtNs_; ++i) {
+        const SpillFile f = spillFiles_.front();
+        const std::string path = spillPath(f);
+        std::ifstream in(path, std::ios::binary);
+        spillBuf_.resize(f.bytes);
+        noteBuffers();
+        if (!in.read(reinterpret_cast<char*>(spillBuf_.data()), std::streamsize(f.bytes))) {
+            lost_.fetch_add(f.records, std::memory_order_relaxed);
+        } else {
+            int status = post(spillBuf_, f.gzip);
+            if (accepted(status)) {
+                sent_.fetch_add(f.records, std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+                wireBytes_.fetch_add(f.bytes, std::memory_order_relaxed);
+            } else {
+                failures_.fetch_add(1, std::memory_order_relaxed);
+                if (!refused(status)) {
+                    failed(nowNs, status);
+                    return;
+                }
+                lost_.fetch_add(f.records, std::memory_order_relaxed);
+            }
+        }
+        std::error_code ec;
+        fs::remove(path, ec);
+        spillBytes_.fetch_sub(f.bytes, std::memory_order_relaxed);
+        spillFiles_.pop_front();
+        nowNs = util::monotonicNs();
+    }
+}
+
+void Uploader::failed(uint64_t nowNs, int status) {
+    if (backoffMs_ == 0) {
+        backoffMs_ = cfg_.backoffMinMs;
+        if (status == 0) {
+            logging::warn(logging::Event::TelemetryUnreachable, cfg_.url, backoffMs_);
+        } else {
+            logging::warn(logging::Event::TelemetryFailed, cfg_.url, status, backoffMs_);
+        }
+    } else {
+        backoffMs_ = std::min<uint64_t>(backoffMs_ * 2, cfg_.backoffMaxMs);
+    }
+    // ±25% jitter so a fleet that lost the collector together does not retry together.
+    uint64_t jitter = (nowNs ^ (nowNs >> 17)) % 501;  // 0..500 ‰ of half the backoff
+    uint64_t delayMs = backoffMs_ * 3 / 4 + backoffMs_ * jitter / 1000;
+    retryAtNs_ = nowNs + delayMs * 1000000;
+}
+
+bool Uploader::resolve() {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host_.c_str(), port_.c_str(), &hints, &res) != 0) return false;
+    addrs_.clear();
+    for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+        if (ai->ai_addrlen > sizeof(sockaddr_storage)) continue;
+        Address a{};
+        std::memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+        a.len = ai->ai_addrlen;
+        a.family = ai->ai_family;
+        a.protocol = ai->ai_protocol;
+        addrs_.push_back(a);
+    }
+    freeaddrinfo(res);
+    noteBuffers();
+    return !addrs_.empty();
+}
+
+int Uploader::post(const std::vector<uint8_t>& body, bool gzip) {
+    // getaddrinfo blocks, so it runs on the first POST and again only after
+    // a connect failure, which the backoff already paces.
+    if (addrs_.empty() && !resolve()) return 0;
+
+    const int timeoutMs = int(cfg_.timeoutMs);
+    int fd = -1;
+    for (const Address& a : addrs_) {
+        fd = socket(a.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, a.protocol);
+        if (fd < 0) continue;
+        int rc = connect(fd, reinterpret_cast<const sockaddr*>(&a.addr), a.len);
+        if (rc < 0 && errno == EINPROGRESS) {
+            pollfd p{fd, POLLOUT, 0};
+            int err = 0;
+            socklen_t errLen = sizeof(err);
+            rc = poll(&p, 1, timeoutMs) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) == 0 && err == 0
+                     ? 0
+                     : -1;
+        }
+        if (rc < 0) {
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        break;
+    }
+    if (fd < 0) {
+        addrs_.clear();  // the collector may have moved; resolve again next time
+        return 0;
+    }
+
+    // Blocking from here on, bounded by the socket timeouts.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    timeval tv{timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    const std::string host = host_.find(':') == std::string::npos ? host_ : "[" + host_ + "]";
+    std::string head = "POST " + path_ + " HTTP/1.1\r\nHost: " + host + (port_ == "80" ? "" : ":" + port_) +
+                       "\r\nContent-Type: application/x-ndjson\r\n" +
+                       (gzip ? "Content-Encoding: gzip\r\n" : "") +
+                       "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+    iovec iov[2] = {{head.data(), head.size()}, {const_cast<uint8_t*>(body.data()), body.size()}};
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    size_t left = head.size() + body.size();
+    while (left > 0) {
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            close(fd);
+            return 0;
+        }
+        left -= size_t(n);
+        // Skip what went out.
+        while (n > 0 && msg.msg_iovlen > 0) {
+            size_t take = std::min(size_t(n), msg.msg_iov->iov_len);
+            msg.msg_iov->iov_base = static_cast<char*>(msg.msg_iov->iov_base) + take;
+            msg.msg_iov->iov_len -= take;
+            n -= ssize_t(take);
+            if (msg.msg_iov->iov_len == 0) {
+                ++msg.msg_iov;
+                --msg.msg_iovlen;
+            }
+        }
+    }
+
+    // Only the status line matters.
+    char resp[256];
+    size_t got = 0;
+    while (got < sizeof(resp) - 1) {
+        ssize_t n = recv(fd, resp + got, sizeof(resp) - 1 - got, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        got += size_t(n);
+        resp[got] = '\0';
+        if (std::strstr(resp, "\r\n")) break;
+    }
+    close(fd);
+    resp[got] = '\0';
+    int status = 0;
+    if (std::sscanf(resp, "HTTP/1.%*d %d", &status) != 1) return 0;
+    return status;
+}
+
+void Uploader::spill(const std::vector<uint8_t>& body, bool gzip, uint64_t records) {
+    if (cfg_.spillDir.empty() || body.size() > cfg_.spillCapBytes) {
+        lost_.fetch_add(records, std::memory_order_relaxed);
+        return;
+    }
+    evictSpill(body.size());
+
+    SpillFile f{nextSpillSeq_++, records, body.size(), gzip};
+    const std::string path = spillPath(f);
+    const std::string tmp = cfg_.spillDir + "/.partial";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(body.data()), std::streamsize(body.size()));
+        if (!out) {
+            logging::warn(logging::Event::TelemetrySpillFailed, tmp);
+            lost_.fetch_add(records, std::memory_order_relaxed);
+            return;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);  // a crash never leaves a truncated batch behind
+    if (ec) {
+        logging::warn(logging::Event::TelemetrySpillFailed, path);
+        lost_.fetch_add(records, std::memory_order_relaxed);
+        return;
+    }
+    spillFiles_.push_back(f);
+    spillBytes_.fetch_add(f.bytes, std::memory_order_relaxed);
+    spilled_.fetch_add(records, std::memory_order_relaxed);
+}
+
+void Uploader::evictSpill(uint64_t incoming) {
+    std::error_code ec;
+    while (!spillFiles_.empty() && spillBytes_.load(std::memory_order_relaxed) + incoming > cfg_.spillCapBytes) {
+        const SpillFile& old = spillFiles_.front();
+        fs::remove(spillPath(old), ec);
+        spillBytes_.fetch_sub(old.bytes, std::memory_order_relaxed);
+        spillEvicted_.fetch_add(old.records, std::memory_order_relaxed);
+        spillFiles_.pop_front();
+    }
+}
+
+std::string Uploader::spillPath(const SpillFile& f) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/%020llu-%llu%s", (unsigned long long)f.seq, (unsigned long long)f.records,
+                  f.gzip ? kSpillSuffixGz : kSpillSuffix);
+    return cfg_.spillDir + name;
+}
+
+void Uploader::scanSpill() {
+    spillFiles_.clear();
+    uint64_t bytes = 0;
+    std::error_code ec;
+    for (const fs::directory_entry& e : fs::directory_iterator(cfg_.spillDir, ec)) {
+        const std::string name = e.path().filename().string();
+        unsigned long long seq = 0, records = 0;
+        int used = 0;
+        if (std::sscanf(name.c_str(), "%20llu-%llu%n", &seq, &records, &used) != 2) {
+            if (name == ".partial") fs::remove(e.path(), ec);
+            continue;
+        }
+        const std::string suffix = name.substr(size_t(used));
+        if (suffix != kSpillSuffix && suffix != kSpillSuffixGz) continue;
+        uint64_t size = e.file_size(ec);
+        if (ec) continue;
+        spillFiles_.push_back({seq, records, size, suffix == kSpillSuffixGz});
+        bytes += size;
+    }
+    std::sort(spillFiles_.begin(), spillFiles_.end(),
+              [](const SpillFile& a, const SpillFile& b) { return a.seq < b.seq; });
+    nextSpillSeq_ = spillFiles_.empty() ? 0 : spillFiles_.back().seq + 1;
+    spillBytes_.store(bytes, std::memory_order_relaxed);
+    // The cap may have been lowered since the previous run.
+    evictSpill(0);
+}
+
+} // namespace telemetry
@@ -0,0 +1,78 @@
+#include "comm/shm_ring_writer.h"
+#include "comm/ShmRing.hpp"
+#include "util/Clock.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct wt_shm_writer {
+    shm::RingHeader* hdr = nullptr;
+    size_t mapSize = 0;
+};
+
+extern "C" wt_shm_writer* wt_shm_writer_open(const char* path) {
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || size_t(st.st_size) < shm::kSlotsOffset) {
+        close(fd);
+        errno = EINVAL;
+        return nullptr;
+    }
+    void* p = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return nullptr;
+
+    auto* hdr = static_cast<shm::RingHeader*>(p);
+    if (hdr->magic != shm::kMagic || hdr->version != shm::kLayoutVersion ||
+        hdr->slotSize != shm::kSlotSize ||
+        shm::mappingSize(hdr->capacity) > size_t(st.st_size)) {
+        munmap(p, size_t(st.st_size));
+        errno = EPROTO;
+        return nullptr;
+    }
+
+    auto* w = new (std::nothrow) wt_shm_writer;
+    if (!w) {
+        munmap(p, size_t(st.st_size));
+        errno = ENOMEM;
+        return nullptr;
+    }
+    w->hdr = hdr;
+    w->mapSize = size_t(st.st_size);
+    return w;
+}
+
+extern "C" int wt_shm_writer_send(wt_shm_writer* w, uint8_t op, uint8_t actuator, int32_t arg,
+                                  uint64_t sent_ns) {
+    shm::RingHeader* hdr = w->hdr;
+    uint64_t head = hdr->head.load(std::memory_order_relaxed);
+    if (head - hdr->tail.load(std::memory_order_acquire) >= hdr->capacity) {
+        hdr->producerDrops.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    // Sequence numbers follow the ring index so they stay monotonic across
+    // producer restarts while App keeps running.
+    if (sent_ns == 0) sent_ns = util::monotonicNs();
+    proto::writeHeader(shm::slotAt(hdr, head), static_cast<proto::Op>(op), actuator, arg,
+                       static_cast<uint32_t>(head + 1), sent_ns);
+    hdr->head.store(head + 1, std::memory_order_seq_cst);
+
+    // Only pay for the syscall when the consumer is actually parked.
+    if (hdr->consumerWaiting.load(std::memory_order_seq_cst)) {
+        hdr->futexWord.fetch_add(1, std::memory_order_release);
+        shm::futexWake(&hdr->futexWord);
+    }
+    return 0;
+}
+
+extern "C" void wt_shm_writer_close(wt_shm_writer* w) {
+    if (!w) return;
+    munmap(w->hdr, w->mapSize);
+    delete w;
+}
@@ -1,15 +1,24 @@
 #include "control/ServoController.hpp"
-#include <chrono>
-#include <filesystem>
-#include <fstream>
-#include <iostream>
-#include <stdexcept>
-#include <thread>
-
-ServoController::ServoController(const std::string& chipPath, unsigned int channel)
-    : chipPath_(chipPath), channel_(channel) {
-    pwmPath_ = chipPath_ + "/pwm" + std::to_string(channel_);
-}
+#include "app/CommandProtocol.hpp"
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
+#include "util/Metrics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr double kMaxAngle = 180.0;
+
+// Close enough to the target to snap and stop ticking.
+constexpr double kAngleEpsilon = 0.05;
+
+} // namespace
+
+ServoController::ServoController(const std::string& chipPath, unsigned int channel,
+                                 const ServoMotion& motion)
+    : pwm_(chipPath, channel), motion_(motion) {}
 
 ServoController::~ServoController() {
     stop();
@@ -18,9 +27,19 @@ ServoController::~ServoController() {
 void ServoController::start() {
     if (running_) return;
     setupPWM();
+    anchorNs_ = util::monotonicNs();
+    clock_.rearm();
     running_ = true;
     worker_ = std::thread(&ServoController::controlLoop, this);
-    std::cout << "[Servo] Started on " << pwmPath_ << "\n";
+    logging::info(logging::Event::ServoStarted, pwm_.path());
+}
+
+void ServoController::startPolled() {
+    if (running_) return;
+    setupPWM();
+    anchorNs_ = util::monotonicNs();
+    running_ = true;
+    logging::info(logging::Event::ServoStartedPolled, pwm_.path());
 }
 
 void ServoController::stop() {
@@ -29,84 +48,130 @@ void ServoController::stop() {
         return;
     }
     running_ = false;
-    qCv_.notify_all();
+    queue_.wakeAll();
+    clock_.interrupt();  // don't wait out the rest of the PWM period
     if (worker_.joinable()) worker_.join();
     teardownPWM();
-    std::cout << "[Servo] Stopped\n";
+    logging::info(logging::Event::ServoStopped);
 }
 
-void ServoController::pushCommand(int cmd) {
-    {
-        std::lock_guard<std::mutex> lk(qMutex_);
-        queue_.push(cmd);
-    }
-    qCv_.notify_one();
+void ServoController::pushCommand(int poseCode, uint64_t rxNs) {
+    int32_t milliDegrees = proto::poseMilliDegrees(poseCode);
+    if (milliDegrees >= 0) pushAngle(milliDegrees, rxNs);  // ignore unrelated commands
+}
+
+void ServoController::pushAngle(int32_t milliDegrees, uint64_t rxNs) {
+    ServoSetpoint sp;
+    sp.milliDegrees = std::clamp<int32_t>(milliDegrees, 0, int32_t(kMaxAngle * 1000));
+    sp.rxNs = rxNs;
+    sp.enqueuedNs = util::monotonicNs();
+    if (rxNs) metrics::registry().record(metrics::Stage::Enqueue, sp.enqueuedNs - rxNs);
+    queue_.push(sp);
+}
+
+uint32_t ServoController::dutyForAngle(double degrees) const {
+    degrees = std::clamp(degrees, 0.0, kMaxAngle);  // an overshoot at either end holds there
+    return minDutyNs_ + static_cast<uint32_t>(degrees / kMaxAngle * double(maxDutyNs_ - minDutyNs_) + 0.5);
 }
 
 void ServoController::controlLoop() {
+    ServoSetpoint sp;
     while (running_) {
-        std::unique_lock<std::mutex> lk(qMutex_);
-        qCv_.wait(lk, [&] { return !queue_.empty() || !running_; });
-        if (!running_) break;
-        int cmd = queue_.front();
-        queue_.pop();
-        lk.unlock();
-
-        if (cmd == 2) {  // lowest angle
-            dutyNs_ = minDutyNs_ + (180.0f / 180.0f) * (maxDutyNs_ - minDutyNs_);
-        } else if (cmd == 3) {  // middle angle
-            dutyNs_ = minDutyNs_ + (162.5f / 180.0f) * (maxDutyNs_ - minDutyNs_);
-        } else if (cmd == 4) {  // highest angle
-            dutyNs_ = minDutyNs_ + (145.0f / 180.0f) * (maxDutyNs_ - minDutyNs_);
-        } else {
-            continue;  // ignore unrelated commands
+        if (atRest()) {
+            // At rest: park until a new target arrives, then rejoin the period grid.
+            if (!queue_.popWait(sp, running_)) break;
+            takeSetpoint(sp);
+            clock_.beginAligned(anchorNs_, periodNs_);
         }
 
-        try {
-            writeFile(pwmPath_ + "/duty_cycle", std::to_string(dutyNs_));
-        } catch (const std::exception& e) {
-            std::cerr << "[Servo] Failed to update duty cycle: " << e.what() << "\n";
-        }
+        if (!clock_.sleepUntilDeadline()) break;
+        clock_.advance(periodNs_);
+        tick();
     }
 }
 
-void ServoController::setupPWM() {
-    namespace fs = std::filesystem;
-    std::error_code ec;
-    if (!fs::exists(pwmPath_, ec)) {
-        writeFile(chipPath_ + "/export", std::to_string(channel_));
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+uint64_t ServoController::poll(uint64_t nowNs) {
+    if (atRest()) {
+        ServoSetpoint sp;
+        if (!queue_.tryPop(sp)) return 0;
+        takeSetpoint(sp);
+        clock_.beginAligned(anchorNs_, periodNs_);
     }
-    writeFile(pwmPath_ + "/period", std::to_string(periodNs_));
-    writeFile(pwmPath_ + "/duty_cycle", std::to_string(dutyNs_));
-    writeFile(pwmPath_ + "/enable", "1");
+    if (nowNs < clock_.deadlineNs()) return clock_.deadlineNs();
+
+    clock_.wokeAt(nowNs);
+    clock_.advance(periodNs_);
+    tick();
+    return atRest() ? 0 : clock_.deadlineNs();
 }
 
-void ServoController::teardownPWM() {
-    namespace fs = std::filesystem;
-    std::error_code ec;
-    if (fs::exists(pwmPath_ + "/enable", ec)) {
-        try {
-            writeFile(pwmPath_ + "/enable", "0");
-        } catch (...) {
-            // ignore
+void ServoController::tick() {
+    ticks_.fetch_add(1, std::memory_order_relaxed);
+
+    // Everything that arrived during the last period collapses into the newest target.
+    ServoSetpoint sp;
+    while (queue_.tryPop(sp)) takeSetpoint(sp);
+
+    const double dt = periodNs_ * 1e-9;
+    const double a = motion_.maxAccelDegPerSec2;
+    const double err = target_ - angle_;
+
+    if (motion_.maxVelDegPerSec <= 0.0 || a <= 0.0) {
+        angle_ = target_;  // limits disabled: jump like the old controller
+        velocity_ = 0.0;
+    } else {
+        // Fastest speed from which we can still stop at the target, capped at vmax.
+        double vWanted = std::copysign(std::min(motion_.maxVelDegPerSec, std::sqrt(2.0 * a * std::fabs(err))), err);
+        const double vPrev = velocity_;
+        velocity_ += std::clamp(vWanted - velocity_, -a * dt, a * dt);
+        double next = angle_ + velocity_ * dt;
+        bool crossed = (target_ - next) * err <= 0.0;
+        // Landing on the target this period means moving at vLand and then
+        // stopping; snap only if both stay within the acceleration limit.
+        // Otherwise keep braking, overshoot and come back (e.g. retargeted
+        // to the current angle, or just ahead of it, at speed).
+        const double vLand = err / dt;
+        bool canLand = std::fabs(vLand - vPrev) <= a * dt && std::fabs(vLand) <= a * dt;
+        if (canLand && (crossed || std::fabs(target_ - next) < kAngleEpsilon)) {
+            angle_ = target_;
+            velocity_ = 0.0;
+        } else {
+            angle_ = next;
         }
     }
-    if (fs::exists(chipPath_ + "/unexport", ec)) {
-        try {
-            writeFile(chipPath_ + "/unexport", std::to_string(channel_));
-        } catch (...) {
+
+    uint32_t duty = dutyForAngle(angle_);
+    if (duty != dutyNs_) {
+        dutyNs_ = duty;
+        int rc = pwm_.setDuty(dutyNs_);
+        dutyWrites_.fetch_add(1, std::memory_order_relaxed);
+        if (rc < 0 && writeErrors_.fetch_add(1, std::memory_order_relaxed) == 0) {
+            // Report the first failure only; the count is available via writeErrors().
+            logging::error(logging::Event::ServoWriteFailed, std::strerror(-rc));
         }
     }
-}
 
-void ServoController::writeFile(const std::string& path, const std::string& value) {
-    std::ofstream file(path);
-    if (!file) {
-        throw std::runtime_error("[Servo] Failed to open " + path);
-    }
-    file << value;
-    if (!file) {
-        throw std::runtime_error("[Servo] Failed to write " + path);
+    // The newest setpoint has now reached the output (or needed no change).
+    if (pending_.enqueuedNs != 0) {
+        uint64_t now = util::monotonicNs();
+        auto& m = metrics::registry();
+        m.record(metrics::Stage::Actuate, now - pendingDequeuedNs_);
+        if (pending_.rxNs) m.record(metrics::Stage::EndToEnd, now - pending_.rxNs);
+        pending_ = {};
     }
-}
\ No newline at end of file
+}
+
+void ServoController::takeSetpoint(const ServoSetpoint& sp) {
+    target_ = sp.milliDegrees / 1000.0;
+    pendingDequeuedNs_ = util::monotonicNs();
+    metrics::registry().record(metrics::Stage::Dequeue, pendingDequeuedNs_ - sp.enqueuedNs);
+    pending_ = sp;
+}
+
+void ServoController::setupPWM() {
+    pwm_.open(periodNs_, dutyNs_);
+}
+
+void ServoController::teardownPWM() {
+    pwm_.close();
+}
@@ -0,0 +1,106 @@
+#include "control/StepScheduler.hpp"
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+TrapezoidRamp::TrapezoidRamp(const MotionProfile& profile) : p_(profile), v_(profile.startStepsPerSec) {
+    p_.startStepsPerSec = std::max(1.0, p_.startStepsPerSec);
+    p_.maxStepsPerSec = std::max(p_.startStepsPerSec, p_.maxStepsPerSec);
+    v_ = p_.startStepsPerSec;
+}
+
+void TrapezoidRamp::reset() {
+    v_ = p_.startStepsPerSec;
+}
+
+uint64_t TrapezoidRamp::nextIntervalNs(int64_t stepsRemaining) {
+    // Steps needed to brake from v to the start rate: (v^2 - v0^2) / 2a.
+    const double v0 = p_.startStepsPerSec;
+    const double a = p_.accelStepsPerSec2;
+    if (a <= 0.0) {
+        v_ = p_.maxStepsPerSec;
+    } else {
+        double brakeSteps = (v_ * v_ - v0 * v0) / (2.0 * a);
+        if (double(stepsRemaining) <= brakeSteps) {
+            v_ = std::sqrt(std::max(v0 * v0, v_ * v_ - 2.0 * a));
+        } else if (v_ < p_.maxStepsPerSec) {
+            v_ = std::min(p_.maxStepsPerSec, std::sqrt(v_ * v_ + 2.0 * a));
+        }
+    }
+    return static_cast<uint64_t>(1e9 / v_);
+}
+
+void StepScheduler::configureThread(const StepperTiming& timing, const char* name) {
+    if (timing.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(timing.cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            logging::warn(logging::Event::PinFailed, name, timing.cpu, std::strerror(rc));
+        }
+    }
+    if (timing.rtPriority > 0) {
+        sched_param sp{};
+        sp.sched_priority = timing.rtPriority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if (rc != 0) {
+            logging::warn(logging::Event::RtUnavailable, name, timing.rtPriority, std::strerror(rc));
+        }
+    }
+}
+
+void StepScheduler::begin() {
+    deadlineNs_ = util::monotonicNs();
+}
+
+void StepScheduler::beginAligned(uint64_t anchorNs, uint64_t periodNs) {
+    uint64_t now = util::monotonicNs();
+    uint64_t periods = now > anchorNs ? (now - anchorNs + periodNs - 1) / periodNs : 0;
+    deadlineNs_ = anchorNs + periods * periodNs;
+    intervalNs_ = periodNs;
+}
+
+bool StepScheduler::sleepUntilDeadline() {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadlineNs_ / 1000000000ull);
+    ts.tv_nsec = static_cast<long>(deadlineNs_ % 1000000000ull);
+    // Not clock_nanosleep(TIMER_ABSTIME): nothing but a signal can end that
+    // early, and stop() must not wait out a slow step interval. A futex wait
+    // with FUTEX_WAIT_BITSET takes the same absolute CLOCK_MONOTONIC
+    // deadline, and interrupt() wakes it through the word. Spurious wakeups
+    // and EINTR just re-wait.
+    while (interrupted_.load(std::memory_order_acquire) == 0) {
+        long rc = syscall(SYS_futex, &interrupted_, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, 0u, &ts,
+                          nullptr, FUTEX_BITSET_MATCH_ANY);
+        if (rc < 0 && errno == ETIMEDOUT) break;
+    }
+    if (interrupted_.load(std::memory_order_acquire) != 0) return false;
+
+    wokeAt(util::monotonicNs());
+    return true;
+}
+
+void StepScheduler::wokeAt(uint64_t nowNs) {
+    uint64_t late = nowNs > deadlineNs_ ? nowNs - deadlineNs_ : 0;
+    lateness_.record(late);
+
+    // Missed by more than a whole step (e.g. preempted): re-anchor rather
+    // than firing a burst of catch-up steps the motor cannot follow.
+    if (late > intervalNs_) deadlineNs_ = nowNs;
+}
+
+void StepScheduler::interrupt() {
+    interrupted_.store(1, std::memory_order_release);
+    syscall(SYS_futex, &interrupted_, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT_MAX, nullptr, nullptr, 0);
+}
@@ -1,12 +1,47 @@
 #include "control/StepperController.hpp"
-#include <iostream>
-#include <chrono>
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
+#include "util/Metrics.hpp"
+#include <cstring>
 #include <thread>
-#include <algorithm>
+#include <stdexcept>
+
+const char* name(DriveMode m) {
+    switch (m) {
+        case DriveMode::Wave: return "wave";
+        case DriveMode::Full: return "full";
+        case DriveMode::Half: return "half";
+        case DriveMode::Micro: return "micro";
+    }
+    return "?";
+}
+
+bool parseDriveMode(const char* s, DriveMode& out) {
+    for (DriveMode m : {DriveMode::Wave, DriveMode::Full, DriveMode::Half, DriveMode::Micro}) {
+        if (std::strcmp(s, name(m)) == 0) {
+            out = m;
+            return true;
+        }
+    }
+    return false;
+}
 
 StepperController::StepperController(const std::vector<unsigned int>& gpioLines,
-                                     const std::string& chipName)
-    : chipName_(chipName), lines_(gpioLines) {}
+                                     const std::string& chipName,
+                                     const StepperTiming& timing,
+                                     DriveMode mode)
+    : lines_(gpioLines), io_(chipName), mode_(mode), timing_(timing), ramp_(timing.profile) {
+    switch (mode_) {
+        case DriveMode::Wave: onDeadline_ = &StepperController::onDeadlineFor<DriveMode::Wave>; break;
+        case DriveMode::Full: onDeadline_ = &StepperController::onDeadlineFor<DriveMode::Full>; break;
+        case DriveMode::Half: onDeadline_ = &StepperController::onDeadlineFor<DriveMode::Half>; break;
+        case DriveMode::Micro: onDeadline_ = &StepperController::onDeadlineFor<DriveMode::Micro>; break;
+    }
+}
+
+size_t StepperController::slotsPerStep() const {
+    return mode_ == DriveMode::Micro ? drive::Policy<DriveMode::Micro>::kSlots : 1;
+}
 
 StepperController::~StepperController() {
     stop();
@@ -15,126 +50,196 @@ StepperController::~StepperController() {
 void StepperController::start() {
     if (running_) return;
     setupGPIO();
+    scheduler_.rearm();
     running_ = true;
     controlThread_ = std::thread(&StepperController::controlLoop, this);
-    std::cout << "[Stepper] Started using " << chipName_ << "\n";
+    logging::info(logging::Event::StepperStarted, io_.name());
+}
+
+void StepperController::startPolled() {
+    if (running_) return;
+    setupGPIO();
+    running_ = true;
+    logging::info(logging::Event::StepperStartedPolled, io_.name());
 }
 
 void StepperController::stop() {
     if (!running_) return;
     running_ = false;
-    qCv_.notify_all();
+    cmdQueue_.wakeAll();
+    scheduler_.interrupt();  // cut short a step interval in progress
     if (controlThread_.joinable()) controlThread_.join();
+    direction_ = 0;
+    slot_ = 0;
+    writePhase(0);
     cleanupGPIO();
-    std::cout << "[Stepper] Stopped.\n";
+    logging::info(logging::Event::StepperStopped);
 }
 
-void StepperController::pushCommand(int cmd) {
-    {
-        std::lock_guard<std::mutex> lk(qMutex_);
-        while (!cmdQueue_.empty()) {
-            cmdQueue_.pop();
-        }
-        cmdQueue_.push(cmd);
+void StepperController::pushCommand(StepperCommand cmd) {
+    cmd.enqueuedNs = util::monotonicNs();
+    if (cmd.rxNs) metrics::registry().record(metrics::Stage::Enqueue, cmd.enqueuedNs - cmd.rxNs);
+    uint64_t evicted = 0;
+    cmdQueue_.push(cmd, &evicted);
+    if (evicted) metrics::registry().add(metrics::Counter::Dropped, evicted);
+}
+
+void StepperController::applyCommand(const StepperCommand& cmd) {
+    switch (cmd.kind) {
+        case StepperCommand::Kind::Jog:
+            // Same sign test as the protocol; a jog without a direction keeps the target.
+            if (cmd.value != 0) target_ = position() + (cmd.value > 0 ? kJogSteps : -kJogSteps);
+            break;
+        case StepperCommand::Kind::MoveTo:
+            target_ = cmd.value;
+            break;
+        case StepperCommand::Kind::MoveBy:
+            target_ += cmd.value;
+            break;
+        case StepperCommand::Kind::Stop:
+            target_ = position();
+            break;
     }
-    qCv_.notify_one();
+    targetPublished_.store(target_, std::memory_order_relaxed);
+
+    uint64_t now = util::monotonicNs();
+    metrics::registry().record(metrics::Stage::Dequeue, now - cmd.enqueuedNs);
+    if (pending_.enqueuedNs == 0) pending_ = {cmd.rxNs, cmd.enqueuedNs, now};
+    if (reactSinceNs_ == 0) reactSinceNs_ = cmd.enqueuedNs;
+}
+
+void StepperController::wake(const StepperCommand& cmd) {
+    applyCommand(cmd);
+    ramp_.reset();
+    slot_ = 0;
+    scheduler_.begin();
 }
 
 void StepperController::controlLoop() {
+    StepScheduler::configureThread(timing_, "[Stepper]");
+
+    StepperCommand cmd;
+    uint64_t next = 0;
     while (running_) {
-        std::unique_lock<std::mutex> lk(qMutex_);
-        qCv_.wait(lk, [&]{ return !cmdQueue_.empty() || !running_; });
-        if (!running_) break;
-
-        int cmd = cmdQueue_.front();
-        cmdQueue_.pop();
-        lk.unlock();
-
-        if (cmd == 34) {
-            std::cout << "[Stepper] Command: CW\n";
-            stepCW(stepsPerCommand_);
-        } else if (cmd == 28) {
-            std::cout << "[Stepper] Command: CCW\n";
-            stepCCW(stepsPerCommand_);
-        } else {
-            std::cout << "[Stepper] Unknown cmd: " << cmd << "\n";
+        if (next == 0) {
+            // Idle with coils released: park until the next command.
+            pending_ = {};
+            reactSinceNs_ = 0;
+            if (!cmdQueue_.popWait(cmd, running_)) break;
+            wake(cmd);
+        } else if (!scheduler_.sleepUntilDeadline()) {
+            break;
         }
+        next = onDeadline();
     }
 }
 
-/* ---------------- GPIO setup / teardown ---------------- */
-
-void StepperController::setupGPIO() {
-    chip_ = gpiod_chip_open_by_name(chipName_.c_str());
-    if (!chip_) {
-        throw std::runtime_error("[Stepper] Failed to open " + chipName_);
+uint64_t StepperController::poll(uint64_t nowNs) {
+    if (direction_ == 0 && position() == target_) {
+        StepperCommand cmd;
+        pending_ = {};
+        reactSinceNs_ = 0;
+        if (!cmdQueue_.tryPop(cmd)) return 0;
+        wake(cmd);
+    } else if (nowNs < scheduler_.deadlineNs()) {
+        return scheduler_.deadlineNs();  // new commands are picked up at the deadline
+    } else {
+        scheduler_.wokeAt(nowNs);
     }
+    return onDeadline();
+}
 
-    for (unsigned int lineOffset : lines_) {
-        gpiod_line* line = gpiod_chip_get_line(chip_, lineOffset);
-        if (!line) {
-            throw std::runtime_error("[Stepper] Failed to get line " + std::to_string(lineOffset));
-        }
-        if (gpiod_line_request_output(line, "Stepper", 0) < 0) {
-            throw std::runtime_error("[Stepper] Failed to request line " + std::to_string(lineOffset));
+template <DriveMode M>
+uint64_t StepperController::onDeadlineFor() {
+    using Policy = drive::Policy<M>;
+    if constexpr (Policy::kSlots > 1) {
+        // Mid-step: play the rest of this phase's PWM pattern first.
+        if (slot_ != 0) {
+            writePhase(Policy::kTable[phase_][slot_]);
+            slot_ = (slot_ + 1) % Policy::kSlots;
+            scheduler_.advance(slotNs_);
+            return scheduler_.deadlineNs();
         }
-        handles_.push_back(line);
     }
 
-    std::cout << "[Stepper] GPIO lines configured\n";
+    // Retarget between steps; never blocks.
+    StepperCommand cmd;
+    while (cmdQueue_.tryPop(cmd)) applyCommand(cmd);
+
+    int64_t remaining = target_ - position();
+    int wanted = (remaining > 0) - (remaining < 0);
+    int64_t ahead = (wanted == direction_) ? (remaining < 0 ? -remaining : remaining) : 0;
+
+    if (ahead == 0 && ramp_.atStartSpeed()) {
+        // Slow enough to stop or reverse on the spot.
+        if (wanted == 0) {
+            // The last phase has been held for one interval; release the coils.
+            if (direction_ != 0) {
+                direction_ = 0;
+                writePhase(0);
+            }
+            return 0;
+        }
+        direction_ = wanted;
+        ahead = remaining < 0 ? -remaining : remaining;
+    }
+    if (direction_ == 0) direction_ = wanted;
+
+    // Moving the wrong way or too fast to stop: keep going while the ramp brakes.
+    stepOnce<M>(direction_);
+    uint64_t intervalNs = ramp_.nextIntervalNs(ahead > 0 ? ahead - 1 : 0);
+    if constexpr (Policy::kSlots > 1) {
+        slotNs_ = intervalNs / Policy::kSlots;
+        slot_ = 1;
+        intervalNs = slotNs_;
+    }
+    scheduler_.advance(intervalNs);
+    return scheduler_.deadlineNs();
 }
 
-void StepperController::cleanupGPIO() {
-    for (auto* line : handles_) {
-        if (line) gpiod_line_release(line);
-    }
-    handles_.clear();
+/* ---------------- GPIO setup / teardown ---------------- */
 
-    if (chip_) {
-        gpiod_chip_close(chip_);
-        chip_ = nullptr;
+void StepperController::setupGPIO() {
+    if (lines_.size() != kCoils) {
+        throw std::runtime_error("[Stepper] Expected " + std::to_string(kCoils) + " GPIO lines");
     }
+
+    // Request every coil together so each step is a single set-values call.
+    io_.open(lines_.data(), lines_.size(), "Stepper");
+
+    logging::info(logging::Event::StepperConfigured);
 }
 
-/* ---------------- Step logic ---------------- */
+void StepperController::cleanupGPIO() {
+    io_.close();
+}
 
-static const std::vector<std::vector<int>> HALFSTEP_SEQ = {
-    //{1,0,0,0},
-    {1,1,0,0},
-    //{0,1,0,0},
-    {0,1,1,0},
-    //{0,0,1,0},
-    {0,0,1,1},
-    //{0,0,0,1},
-    {1,0,0,1}
-};
-
-void StepperController::stepCW(int steps) {
-    int n = HALFSTEP_SEQ.size();
-    for (int i = 0; i < steps && running_; ++i) {
-        const auto& pattern = HALFSTEP_SEQ[i % n];
-        for (size_t j = 0; j < handles_.size(); ++j) {
-            gpiod_line_set_value(handles_[j], pattern[j]);
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(3));
-    }
+/* ---------------- Step logic ---------------- */
 
-    for (size_t j = 0; j < handles_.size(); ++j)
-        gpiod_line_set_value(handles_[j], 0);
+void StepperController::writePhase(uint8_t mask) {
+    io_.write(mask);
 }
 
-void StepperController::stepCCW(int steps) {
-    std::vector<std::vector<int>> rev = HALFSTEP_SEQ;
-    std::reverse(rev.begin(), rev.end());
-    int n = rev.size();
-    for (int i = 0; i < steps && running_; ++i) {
-        const auto& pattern = rev[i % n];
-        for (size_t j = 0; j < handles_.size(); ++j) {
-            gpiod_line_set_value(handles_[j], pattern[j]);
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+template <DriveMode M>
+void StepperController::stepOnce(int direction) {
+    using Policy = drive::Policy<M>;
+    static_assert((Policy::kPhases & (Policy::kPhases - 1)) == 0, "phase count must be a power of two");
+    const int64_t from = position();
+    phase_ = (phase_ + static_cast<unsigned int>(direction)) & (Policy::kPhases - 1);
+    writePhase(Policy::kTable[phase_][0]);
+    position_.store(from + direction, std::memory_order_relaxed);
+    if (pending_.enqueuedNs != 0) recordActuation();
+    // Reacting means turning toward the target, not one more braking step the old way.
+    if (reactSinceNs_ != 0 && direction == (target_ > from) - (target_ < from)) {
+        reaction_.record(util::monotonicNs() - reactSinceNs_);
+        reactSinceNs_ = 0;
     }
+}
 
-    for (size_t j = 0; j < handles_.size(); ++j)
-        gpiod_line_set_value(handles_[j], 0);
+void StepperController::recordActuation() {
+    uint64_t now = util::monotonicNs();
+    auto& m = metrics::registry();
+    m.record(metrics::Stage::Actuate, now - pending_.dequeuedNs);
+    if (pending_.rxNs) m.record(metrics::Stage::EndToEnd, now - pending_.rxNs);
+    pending_ = {};
 }
@@ -0,0 +1,71 @@
+#include "hal/GpiodLines.hpp"
+#include <array>
+#include <stdexcept>
+
+namespace hal {
+
+namespace {
+
+// Every line mask unpacked into the int-per-line array gpiod expects.
+constexpr std::array<std::array<int, kMaxLines>, 1u << kMaxLines> makeUnpackTable() {
+    std::array<std::array<int, kMaxLines>, 1u << kMaxLines> t{};
+    for (size_t m = 0; m < t.size(); ++m) {
+        for (size_t j = 0; j < kMaxLines; ++j) {
+            t[m][j] = (m >> j) & 1u;
+        }
+    }
+    return t;
+}
+
+constexpr auto kMaskValues = makeUnpackTable();
+
+} // namespace
+
+GpiodLines::GpiodLines(std::string chipName) : chipName_(std::move(chipName)) {}
+
+GpiodLines::~GpiodLines() {
+    close();
+}
+
+void GpiodLines::open(const unsigned int* offsets, size_t count, const char* consumer) {
+    if (count == 0 || count > kMaxLines) {
+        throw std::runtime_error("[GPIO] Unsupported line count " + std::to_string(count));
+    }
+
+    chip_ = gpiod_chip_open_by_name(chipName_.c_str());
+    if (!chip_) {
+        throw std::runtime_error("[GPIO] Failed to open " + chipName_);
+    }
+
+    // gpiod_chip_get_lines takes a non-const array.
+    std::array<unsigned int, kMaxLines> lines{};
+    std::copy(offsets, offsets + count, lines.begin());
+    if (gpiod_chip_get_lines(chip_, lines.data(), static_cast<unsigned int>(count), &bulk_) < 0) {
+        close();
+        throw std::runtime_error("[GPIO] Failed to get lines on " + chipName_);
+    }
+    if (gpiod_line_request_bulk_output(&bulk_, consumer, kMaskValues[0].data()) < 0) {
+        close();
+        throw std::runtime_error("[GPIO] Failed to request lines on " + chipName_);
+    }
+    requested_ = true;
+}
+
+void GpiodLines::close() {
+    if (requested_) {
+        gpiod_line_release_bulk(&bulk_);
+        requested_ = false;
+    }
+    bulk_ = {};
+
+    if (chip_) {
+        gpiod_chip_close(chip_);
+        chip_ = nullptr;
+    }
+}
+
+int GpiodLines::write(uint32_t mask) noexcept {
+    return gpiod_line_set_value_bulk(&bulk_, kMaskValues[mask & ((1u << kMaxLines) - 1)].data());
+}
+
+} // namespace hal
@@ -0,0 +1,111 @@
+#include "hal/Sim.hpp"
+#include "util/Clock.hpp"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace hal {
+
+namespace {
+
+std::atomic<uint32_t> linesOpenUs{0};
+std::atomic<uint32_t> pwmExportUs{0};
+std::atomic<uint32_t> pwmWriteUs{0};
+
+void delay(const std::atomic<uint32_t>& us) {
+    if (uint32_t v = us.load(std::memory_order_relaxed)) std::this_thread::sleep_for(std::chrono::microseconds(v));
+}
+
+// What the kernel keeps per exported channel, keyed by path.
+struct ExportedPwm {
+    uint32_t periodNs = 0;
+    uint32_t dutyNs = 0;
+    bool enabled = false;
+};
+
+std::mutex exportedMutex;
+std::map<std::string, ExportedPwm> exported;
+
+} // namespace
+
+void setSimSetupLatency(const SimSetupLatency& latency) {
+    linesOpenUs.store(latency.linesOpenUs, std::memory_order_relaxed);
+    pwmExportUs.store(latency.pwmExportUs, std::memory_order_relaxed);
+    pwmWriteUs.store(latency.pwmWriteUs, std::memory_order_relaxed);
+}
+
+TransitionLog::TransitionLog(size_t capacity)
+    : entries_(new Transition[capacity]), capacity_(capacity) {}
+
+void TransitionLog::record(uint32_t value) noexcept {
+    size_t n = size_.load(std::memory_order_relaxed);
+    if (n == capacity_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    entries_[n] = Transition{util::monotonicNs(), value};
+    size_.store(n + 1, std::memory_order_release);
+}
+
+void TransitionLog::clear() noexcept {
+    size_.store(0, std::memory_order_release);
+    dropped_.store(0, std::memory_order_relaxed);
+}
+
+SimLines::SimLines(std::string chipName, size_t logCapacity)
+    : chipName_(std::move(chipName)), log_(logCapacity) {}
+
+void SimLines::open(const unsigned int*, size_t, const char*) {
+    delay(linesOpenUs);
+    mask_ = 0;
+}
+
+void SimLines::close() {
+    mask_ = 0;
+}
+
+SimPwm::SimPwm(std::string chipPath, unsigned int channel, size_t logCapacity)
+    : pwmPath_(std::move(chipPath) + "/pwm" + std::to_string(channel)), log_(logCapacity) {}
+
+void SimPwm::open(uint32_t periodNs, uint32_t dutyNs) {
+    if (open_) return;
+    ExportedPwm state;
+    bool wasExported;
+    {
+        std::lock_guard<std::mutex> lock(exportedMutex);
+        auto it = exported.find(pwmPath_);
+        wasExported = it != exported.end();
+        if (wasExported) state = it->second;
+    }
+    // Same read-back as SysfsPwm: export and write only what differs.
+    setupWrites_ = 0;
+    if (!wasExported) {
+        delay(pwmExportUs);
+        ++setupWrites_;
+    }
+    setupWrites_ += unsigned(state.periodNs != periodNs) + unsigned(state.dutyNs != dutyNs) + unsigned(!state.enabled);
+    for (unsigned i = wasExported ? 0 : 1; i < setupWrites_; ++i) delay(pwmWriteUs);
+
+    open_ = true;
+    setPeriod(periodNs);
+    if (state.dutyNs != dutyNs) {
+        setDuty(dutyNs);
+    } else {
+        dutyNs_ = dutyNs;
+    }
+    setEnabled(true);
+    std::lock_guard<std::mutex> lock(exportedMutex);
+    exported[pwmPath_] = {periodNs, dutyNs, true};
+}
+
+void SimPwm::close() {
+    setEnabled(false);
+    if (open_) {
+        std::lock_guard<std::mutex> lock(exportedMutex);
+        exported.erase(pwmPath_);  // unexport
+    }
+    open_ = false;
+}
+
+} // namespace hal
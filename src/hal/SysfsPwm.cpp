@@ -0,0 +1,160 @@
+#include "hal/SysfsPwm.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace hal {
+
+namespace {
+
+bool exists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+// After export the kernel creates pwmN and udev then fixes its permissions.
+// sysfs raises no inotify events for either, so poll, starting at 100 µs and
+// backing off to 2 ms, until the attribute is writable or the budget runs out.
+bool waitWritable(const std::string& path, std::chrono::milliseconds budget) {
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    auto delay = std::chrono::microseconds(100);
+    while (access(path.c_str(), W_OK) != 0) {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(delay);
+        delay = std::min<std::chrono::microseconds>(delay * 2, std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+// One-shot write for attributes that are not kept open (export/unexport).
+int writeOnce(const std::string& path, unsigned int value) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -errno;
+    char buf[16];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    int rc = ::write(fd, buf, size_t(r.ptr - buf)) < 0 ? -errno : 0;
+    ::close(fd);
+    return rc;
+}
+
+} // namespace
+
+SysfsPwm::SysfsPwm(std::string chipPath, unsigned int channel)
+    : chipPath_(std::move(chipPath)), channel_(channel) {
+    pwmPath_ = chipPath_ + "/pwm" + std::to_string(channel_);
+}
+
+SysfsPwm::~SysfsPwm() {
+    close();
+}
+
+int SysfsPwm::openAttr(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("[PWM] Failed to open " + path + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+void SysfsPwm::open(uint32_t periodNs, uint32_t dutyNs) {
+    if (isOpen()) return;
+    setupWrites_ = 0;
+
+    if (!exists(pwmPath_)) {
+        int rc = writeOnce(chipPath_ + "/export", channel_);
+        if (rc < 0) {
+            throw std::runtime_error("[PWM] Failed to export " + pwmPath_ + ": " + std::strerror(-rc));
+        }
+        ++setupWrites_;
+    }
+    if (!waitWritable(pwmPath_ + "/enable", kExportTimeout)) {
+        throw std::runtime_error("[PWM] " + pwmPath_ + " did not appear after export");
+    }
+
+    periodFd_ = openAttr(pwmPath_ + "/period");
+    dutyFd_ = openAttr(pwmPath_ + "/duty_cycle");
+    enableFd_ = openAttr(pwmPath_ + "/enable");
+
+    // Write only what differs from the current state; unreadable counts as different.
+    uint32_t period = 0, duty = 0, enabled = 0;
+    bool periodStale = !readValue(periodFd_, period) || period != periodNs;
+    bool dutyStale = !readValue(dutyFd_, duty) || duty != dutyNs;
+    bool enableStale = !readValue(enableFd_, enabled) || enabled != 1;
+
+    int rc = 0;
+    // The kernel rejects a period shorter than the current duty cycle.
+    if (dutyStale && periodStale && duty > periodNs) {
+        rc = setDuty(dutyNs);
+        dutyStale = false;
+        ++setupWrites_;
+    }
+    if (rc == 0 && periodStale) {
+        rc = setPeriod(periodNs);
+        ++setupWrites_;
+    }
+    if (rc == 0 && dutyStale) {
+        rc = setDuty(dutyNs);
+        ++setupWrites_;
+    }
+    if (rc == 0 && enableStale) {
+        rc = setEnabled(true);
+        ++setupWrites_;
+    }
+    if (rc < 0) {
+        close();
+        throw std::runtime_error("[PWM] Failed to configure " + pwmPath_ + ": " + std::strerror(-rc));
+    }
+}
+
+void SysfsPwm::close() {
+    if (enableFd_ != -1) {
+        setEnabled(false);
+    } else if (exists(pwmPath_ + "/enable")) {
+        writeOnce(pwmPath_ + "/enable", 0);
+    }
+    for (int* fd : {&periodFd_, &dutyFd_, &enableFd_}) {
+        if (*fd != -1) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    if (exists(chipPath_ + "/unexport") && exists(pwmPath_)) {
+        writeOnce(chipPath_ + "/unexport", channel_);
+    }
+}
+
+int SysfsPwm::writeValue(int fd, uint32_t value) noexcept {
+    // sysfs attributes take the whole value from one write at offset 0.
+    char buf[16];
+    auto r = std::to_chars(buf, buf + sizeof(buf), value);
+    ssize_t n = pwrite(fd, buf, size_t(r.ptr - buf), 0);
+    if (n < 0) return -errno;
+    return n == r.ptr - buf ? 0 : -EIO;
+}
+
+bool SysfsPwm::readValue(int fd, uint32_t& value) noexcept {
+    char buf[16];
+    ssize_t n = pread(fd, buf, sizeof(buf), 0);
+    if (n <= 0) return false;
+    auto r = std::from_chars(buf, buf + n, value);
+    return r.ec == std::errc() && r.ptr != buf;
+}
+
+int SysfsPwm::setDuty(uint32_t dutyNs) noexcept {
+    return writeValue(dutyFd_, dutyNs);
+}
+
+int SysfsPwm::setPeriod(uint32_t periodNs) noexcept {
+    return writeValue(periodFd_, periodNs);
+}
+
+int SysfsPwm::setEnabled(bool on) noexcept {
+    return writeValue(enableFd_, on ? 1u : 0u);
+}
+
+} // namespace hal
@@ -1,40 +1,96 @@
 #include "app/App.hpp"
+#include "util/Clock.hpp"
+#include "util/Log.hpp"
 #include <csignal>
-#include <atomic>
 #include <iostream>
-#include <thread>
-#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <sys/signalfd.h>
+#include <unistd.h>
 
-static std::atomic<bool> g_sigint{false};
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0
+              << " [--port N] [--config YAML] [--shm-ring PATH] [--record LOG] [--sessions PATH] [--mode threaded|reactor] [--cpu N]"
+              << " [--track-actuator ID]"
+              << " [--telemetry http://host:port/path] [--telemetry-spill DIR]\n";
+}
 
-static void handle_signal(int) {
-    g_sigint.store(true);
+static double msSince(uint64_t t0) {
+    return double(util::monotonicNs() - t0) / 1e6;
 }
 
 int main(int argc, char** argv) {
-    (void)argc;
-    (void)argv;
+    const uint64_t t0 = util::monotonicNs();
+
+    AppConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            cfg.port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            cfg.actuatorConfigPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--shm-ring") == 0 && i + 1 < argc) {
+            cfg.shmRingPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            cfg.commandLogPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            cfg.sessionLogPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "reactor") == 0) {
+                cfg.execMode = ExecMode::Reactor;
+            } else if (std::strcmp(mode, "threaded") != 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            cfg.telemetry.url = argv[++i];
+        } else if (std::strcmp(argv[i], "--telemetry-spill") == 0 && i + 1 < argc) {
+            cfg.telemetry.spillDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cfg.reactorCpu = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--track-actuator") == 0 && i + 1 < argc) {
+            cfg.analytics.actuator = uint8_t(std::atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Block SIGINT/SIGTERM before any thread exists so every thread inherits
+    // the mask and the signals are only ever delivered through the signalfd.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    int sig_fd = signalfd(-1, &signals, SFD_CLOEXEC);
+    if (sig_fd < 0) {
+        std::cerr << "[fatal] signalfd failed: " << std::strerror(errno) << "\n";
+        return 2;
+    }
 
-    App app;
+    App app(cfg);
     try {
         app.init();
+        app.start();
     } catch (const std::exception& e) {
-        std::cerr << "[fatal] init failed: " << e.what() << "\n";
+        logging::flush();
+        std::cerr << "[fatal] startup failed: " << e.what() << "\n";
         return 2;
     }
-
-    // Signals
-    std::signal(SIGINT,  handle_signal);
-    std::signal(SIGTERM, handle_signal);
-
-    app.start();
+    logging::flush();  // App logs asynchronously; keep its startup lines first
+    std::cout << "[main] ready in " << msSince(t0) << " ms\n";
 
     // Run until Ctrl+C (or systemd stop)
-    while (!g_sigint.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    signalfd_siginfo info{};
+    while (read(sig_fd, &info, sizeof(info)) < 0 && errno == EINTR) {
     }
+    close(sig_fd);
 
-    std::cout << "[main] signal received; stopping…\n";
+    const uint64_t stop_ns = util::monotonicNs();
+    std::cout << "[main] " << strsignal(int(info.ssi_signo)) << "; stopping…\n";
     app.stop();
+    std::cout << "[main] stopped in " << msSince(stop_ns) << " ms\n";
     return 0;
 }
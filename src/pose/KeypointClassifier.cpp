@@ -0,0 +1,188 @@
+#include "pose/KeypointClassifier.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace pose {
+
+namespace {
+
+// GCC/Clang vector extensions at the width SSE and NEON both have; the
+// eight joint lanes are processed as two halves.
+typedef float v4f __attribute__((vector_size(16)));
+typedef int32_t v4i __attribute__((vector_size(16)));
+constexpr size_t kHalf = 4;
+
+// COCO keypoint indices of the three points that define each lane's angle;
+// the angle is measured at the vertex kB.
+//                                elbow   shoulder  hip     knee
+constexpr uint8_t kA[kJoints] = {5, 6,  11, 12,  5, 6,    11, 12};
+constexpr uint8_t kB[kJoints] = {7, 8,  5, 6,    11, 12,  13, 14};
+constexpr uint8_t kC[kJoints] = {9, 10, 7, 8,    13, 14,  15, 16};
+constexpr uint8_t kLeftHip = 11;
+constexpr uint8_t kRightHip = 12;
+
+inline v4f blend(v4i mask, v4f a, v4f b) {
+    return (v4f)(((v4i)a & mask) | ((v4i)b & ~mask));
+}
+
+inline v4i laneMask(uint32_t bits) {
+    const v4i laneBits = {1, 2, 4, 8};
+    return (laneBits & int32_t(bits)) != 0;
+}
+
+// Lanes [H*4, H*4 + 4) of one frame. The indices are compile-time constants,
+// so each gather is a handful of scalar loads and shuffles.
+template <size_t H>
+inline uint32_t measureHalf(const float* kp, float minConfidence, float* cos2) {
+    constexpr size_t o = H * kHalf;
+    auto gather = [kp](const uint8_t* idx, size_t field) {
+        return v4f{kp[3 * idx[o] + field], kp[3 * idx[o + 1] + field], kp[3 * idx[o + 2] + field],
+                   kp[3 * idx[o + 3] + field]};
+    };
+    const v4f bx = gather(kB, 0), by = gather(kB, 1);
+    const v4f ux = gather(kA, 0) - bx, uy = gather(kA, 1) - by;
+    const v4f vx = gather(kC, 0) - bx, vy = gather(kC, 1) - by;
+    const v4f dot = ux * vx + uy * vy;
+    const v4f den = (ux * ux + uy * uy) * (vx * vx + vy * vy);
+
+    const v4i ok = (gather(kA, 2) >= minConfidence) & (gather(kB, 2) >= minConfidence) &
+                   (gather(kC, 2) >= minConfidence) & (den > 1e-12f);
+    const v4f absDot = (v4f)((v4i)dot & 0x7fffffff);
+    const v4f out = blend(ok, dot * absDot / blend(ok, den, v4f{} + 1.0f), v4f{});
+    std::memcpy(cos2 + o, &out, sizeof(out));
+
+    uint32_t valid = 0;
+    for (size_t l = 0; l < kHalf; ++l) valid |= uint32_t(ok[l] & 1) << (o + l);
+    return valid;
+}
+
+// cos(deg)·|cos(deg)|, the space the classifier compares in.
+float signedCos2(float deg) {
+    float c = std::cos(deg * float(M_PI) / 180.0f);
+    return c * std::fabs(c);
+}
+
+} // namespace
+
+const char* name(Joint j) {
+    switch (j) {
+        case Joint::Elbow: return "elbow";
+        case Joint::Shoulder: return "shoulder";
+        case Joint::Hip: return "hip";
+        case Joint::Knee: return "knee";
+    }
+    return "?";
+}
+
+KeypointClassifier::KeypointClassifier(const ClassifierConfig& cfg) : cfg_(cfg) {
+    if (!(cfg_.topDeg < cfg_.bottomDeg) || !(cfg_.smoothing > 0.0f && cfg_.smoothing <= 1.0f)) {
+        throw std::invalid_argument("[pose] Thresholds out of order or smoothing outside (0, 1]");
+    }
+    // A larger angle is a smaller cosine.
+    enterBottom_ = signedCos2(cfg_.bottomDeg);
+    leaveBottom_ = signedCos2(cfg_.bottomDeg - cfg_.hysteresisDeg);
+    enterTop_ = signedCos2(cfg_.topDeg);
+    leaveTop_ = signedCos2(cfg_.topDeg + cfg_.hysteresisDeg);
+}
+
+void KeypointClassifier::reset() {
+    *this = KeypointClassifier(cfg_);
+}
+
+void KeypointClassifier::measure(const uint8_t* frames, size_t count, float minConfidence, JointSample* out) {
+    for (size_t f = 0; f < count; ++f) {
+        float kp[kFrameFloats];
+        std::memcpy(kp, frames + f * kFrameBytes, kFrameBytes);
+        if constexpr (std::endian::native == std::endian::big) {
+            for (float& v : kp) v = std::bit_cast<float>(__builtin_bswap32(std::bit_cast<uint32_t>(v)));  // wire is little-endian
+        }
+
+        JointSample& s = out[f];
+        s.valid = measureHalf<0>(kp, minConfidence, s.cos2.data()) |
+                  measureHalf<1>(kp, minConfidence, s.cos2.data());
+
+        const float lc = kp[3 * kLeftHip + 2], rc = kp[3 * kRightHip + 2];
+        s.hipValid = lc >= minConfidence && rc >= minConfidence;
+        s.hipX = 0.5f * (kp[3 * kLeftHip] + kp[3 * kRightHip]);
+    }
+}
+
+size_t KeypointClassifier::step(const JointSample& sample, proto::Command* out) {
+    ++frames_;
+    size_t n = 0;
+
+    // Smooth every lane; a lane's first valid sample seeds its average.
+    for (size_t h = 0; h < kJoints; h += kHalf) {
+        v4f x, ema;
+        std::memcpy(&x, sample.cos2.data() + h, sizeof(x));
+        std::memcpy(&ema, ema_.data() + h, sizeof(ema));
+        const v4i valid = laneMask(sample.valid >> h);
+        const v4i seen = laneMask(seen_ >> h);
+        const v4f smoothed = ema + cfg_.smoothing * (x - ema);
+        ema = blend(valid & seen, smoothed, blend(valid, x, ema));
+        std::memcpy(ema_.data() + h, &ema, sizeof(ema));
+    }
+    seen_ |= sample.valid;
+
+    const size_t l0 = 2 * size_t(cfg_.driver), l1 = l0 + 1;
+    const bool v0 = sample.valid & (1u << l0), v1 = sample.valid & (1u << l1);
+    if (!v0 && !v1) {
+        ++lowConfidence_;
+    } else {
+        const float m = v0 && v1 ? 0.5f * (ema_[l0] + ema_[l1]) : ema_[v0 ? l0 : l1];
+        if (pose_ == 4) {
+            if (m < leaveTop_) pose_ = m < enterBottom_ ? 2 : 3;
+        } else if (pose_ == 2) {
+            if (m > leaveBottom_) pose_ = m > enterTop_ ? 4 : 3;
+        } else {
+            pose_ = m > enterTop_ ? 4 : m < enterBottom_ ? 2 : 3;
+        }
+        out[n].op = proto::Op::ServoPose;
+        out[n].arg = pose_;
+        ++n;
+    }
+
+    if (sample.hipValid) {
+        hipX_ = hipSeen_ ? hipX_ + cfg_.smoothing * (sample.hipX - hipX_) : sample.hipX;
+        hipSeen_ = true;
+        const float d = hipX_ - cfg_.centerX;
+        const float band = cfg_.lateralDeadband;
+        const float inner = band - cfg_.lateralHysteresis;
+        if (zone_ == 1) {
+            if (d < inner) zone_ = d < -band ? -1 : 0;
+        } else if (zone_ == -1) {
+            if (d > -inner) zone_ = d > band ? 1 : 0;
+        } else {
+            zone_ = d > band ? 1 : d < -band ? -1 : 0;
+        }
+        if (zone_ != 0) {
+            out[n].op = proto::Op::StepperJog;
+            out[n].arg = zone_;
+            ++n;
+        }
+    }
+    return n;
+}
+
+size_t KeypointClassifier::classify(const uint8_t* frames, size_t count, proto::Command* out) {
+    JointSample samples[kBatch];
+    size_t n = 0;
+    for (size_t i = 0; i < count; i += kBatch) {
+        const size_t m = std::min(kBatch, count - i);
+        measure(frames + i * kFrameBytes, m, cfg_.minConfidence, samples);
+        for (size_t k = 0; k < m; ++k) n += step(samples[k], out + n);
+    }
+    return n;
+}
+
+float KeypointClassifier::angleDeg(size_t lane) const {
+    if (lane >= kJoints || !(seen_ & (1u << lane))) return -1.0f;
+    const float s = ema_[lane];
+    const float c = std::copysign(std::sqrt(std::fabs(s)), s);
+    return std::acos(std::clamp(c, -1.0f, 1.0f)) * 180.0f / float(M_PI);
+}
+
+} // namespace pose
@@ -1,11 +1,17 @@
 # pose_inference.py
 import socket, time
+from protocol import FrameWriter, OP_SERVO_POSE, OP_STEPPER_JOG
 
 s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
 s.connect(("127.0.0.1", 5005))  # or "127.0.0.1" if on same machine
 
+frames = FrameWriter(s)
+
 while True:
-    s.send(b'0')
+    frames.send(OP_SERVO_POSE, 2)
+    frames.send(OP_STEPPER_JOG, 1)
+    time.sleep(2)
+    frames.send(OP_SERVO_POSE, 4)
+    frames.send(OP_STEPPER_JOG, -1)
     time.sleep(2)
-    s.send(b'1')
-    time.sleep(2)
\ No newline at end of file
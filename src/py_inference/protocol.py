@@ -0,0 +1,38 @@
+# protocol.py - framed command encoder for App (see include/app/CommandProtocol.hpp)
+import struct, time
+
+NEGOTIATE_BINARY = b'\xb1'
+VERSION = 1
+
+OP_STEPPER_JOG = 1
+OP_SERVO_POSE = 2
+OP_STEPPER_MOVE_TO = 3
+OP_STEPPER_MOVE_BY = 4
+OP_STEPPER_STOP = 5
+OP_SERVO_ANGLE = 6  # arg in millidegrees
+OP_KEYPOINTS = 7    # payload: frames of 17 (x, y, confidence) float32, x/y in 0..1
+
+# version, op, actuator, flags, arg, seq, payload_len, reserved, sent_ns
+_HEADER = struct.Struct('<BBBBiIHHQ')
+_KEYPOINTS = struct.Struct('<51f')
+MAX_KEYPOINT_BATCH = 19  # frames per message; bounded by App's receive buffer
+
+
+class FrameWriter:
+    def __init__(self, sock):
+        self.sock = sock
+        self.seq = 0
+        sock.sendall(NEGOTIATE_BINARY)
+
+    def send(self, op, arg, actuator=0):
+        self.seq = (self.seq + 1) & 0xFFFFFFFF
+        self.sock.sendall(_HEADER.pack(VERSION, op, actuator, 0, arg, self.seq, 0, 0,
+                                       time.monotonic_ns()))
+
+    def send_keypoints(self, frames):
+        """Send raw keypoints for App to classify: a list of frames, each 17
+        (x, y, confidence) triples, at most MAX_KEYPOINT_BATCH per call."""
+        payload = b''.join(_KEYPOINTS.pack(*(v for kp in f for v in kp)) for f in frames)
+        self.seq = (self.seq + 1) & 0xFFFFFFFF
+        self.sock.sendall(_HEADER.pack(VERSION, OP_KEYPOINTS, 0, 0, 0, self.seq, len(payload), 0,
+                                       time.monotonic_ns()) + payload)
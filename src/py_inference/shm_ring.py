@@ -0,0 +1,31 @@
+# shm_ring.py - shared-memory command ring producer (see include/comm/ShmRing.hpp)
+import ctypes, os
+
+from protocol import OP_SERVO_POSE, OP_STEPPER_JOG  # noqa: F401  (re-exported for callers)
+
+_LIB_PATH = os.environ.get("WT_SHM_WRITER_LIB", "libwt_shm_writer.so")
+
+
+class ShmRingWriter:
+    def __init__(self, path="/dev/shm/workout-tracker.ring", lib_path=_LIB_PATH):
+        self._lib = ctypes.CDLL(lib_path, use_errno=True)
+        self._lib.wt_shm_writer_open.restype = ctypes.c_void_p
+        self._lib.wt_shm_writer_open.argtypes = [ctypes.c_char_p]
+        self._lib.wt_shm_writer_send.restype = ctypes.c_int
+        self._lib.wt_shm_writer_send.argtypes = [ctypes.c_void_p, ctypes.c_uint8, ctypes.c_uint8,
+                                                 ctypes.c_int32, ctypes.c_uint64]
+        self._lib.wt_shm_writer_close.argtypes = [ctypes.c_void_p]
+
+        self._w = self._lib.wt_shm_writer_open(path.encode())
+        if not self._w:
+            err = ctypes.get_errno()
+            raise OSError(err, "cannot attach to ring (is workout-tracker running with --shm-ring?)", path)
+
+    def send(self, op, arg, actuator=0):
+        """Returns False if the ring was full and the command was dropped."""
+        return self._lib.wt_shm_writer_send(self._w, op, actuator, arg, 0) == 0
+
+    def close(self):
+        if self._w:
+            self._lib.wt_shm_writer_close(self._w)
+            self._w = None
@@ -0,0 +1,99 @@
+#include "app/App.hpp"
+#include "app/Replay.hpp"
+#include "comm/CommandLog.hpp"
+#include "util/Log.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+// Replays a log written with --record against the actuators this binary was
+// built for (real, or simulated with -DWORKOUT_TRACKER_SIM=ON).
+
+static std::atomic<bool> g_cancel{false};
+
+static void handle_signal(int) {
+    g_cancel.store(true);
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "usage: " << argv0
+              << " LOG [--speed X|max] [--config YAML] [--mode threaded|reactor] [--drain-ms N]\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char* logPath = argv[1];
+    double speed = 1.0;
+    int drainMs = 500;
+    AppConfig cfg;
+    cfg.port = 0;  // ephemeral: replay does not need the socket
+    cfg.statsSocketPath.clear();
+
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            const char* s = argv[++i];
+            speed = std::strcmp(s, "max") == 0 ? 0.0 : std::atof(s);
+            if (speed < 0.0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            cfg.actuatorConfigPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "reactor") == 0) {
+                cfg.execMode = ExecMode::Reactor;
+            } else if (std::strcmp(mode, "threaded") != 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--drain-ms") == 0 && i + 1 < argc) {
+            drainMs = std::atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    cmdlog::Reader log(logPath);
+    App app(cfg);
+    try {
+        log.open();
+        app.init();
+        app.start();
+    } catch (const std::exception& e) {
+        logging::flush();
+        std::cerr << "[fatal] " << e.what() << "\n";
+        return 2;
+    }
+
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    logging::flush();
+    std::cout << "[replay] " << log.size() << " records from " << logPath << " at ";
+    if (speed > 0.0) {
+        std::cout << speed << "x\n";
+    } else {
+        std::cout << "max speed\n";
+    }
+    ReplayResult res = replayLog(log, app, speed, g_cancel);
+
+    double secs = double(res.elapsedNs) / 1e9;
+    std::cout << "[replay] " << res.commands << " commands in " << secs * 1e3 << " ms ("
+              << (secs > 0 ? double(res.commands) / secs : 0.0) << " cmd/s), max lag "
+              << res.maxLagNs / 1000 << " us\n";
+
+    // Let the actuators finish what the last commands started.
+    std::this_thread::sleep_for(std::chrono::milliseconds(drainMs));
+    app.stop();
+    return 0;
+}
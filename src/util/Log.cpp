@@ -0,0 +1,317 @@
+#include "util/Log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+namespace {
+
+constexpr size_t kRingRecords = 1024;  // per thread: 128 KiB
+constexpr size_t kCacheLine = 64;
+// After a writer wakes the drain thread, let a burst accumulate this long.
+constexpr auto kBatchDelay = std::chrono::milliseconds(5);
+
+const char* const kFormats[] = {
+#define WT_LOG_FORMAT(id, fmt) fmt,
+    WT_LOG_EVENTS(WT_LOG_FORMAT)
+#undef WT_LOG_FORMAT
+};
+constexpr size_t kEvents = sizeof(kFormats) / sizeof(kFormats[0]);
+
+static_assert((kRingRecords & (kRingRecords - 1)) == 0, "ring size must be a power of two");
+
+/** Single-producer/single-consumer ring; the producer is the owning thread. */
+struct Ring {
+    alignas(kCacheLine) std::atomic<uint64_t> head{0};  // next slot to write
+    uint64_t cachedTail = 0;                            // producer's last view of tail
+    std::atomic<uint64_t> dropped{0};                   // written by the producer only
+    alignas(kCacheLine) std::atomic<uint64_t> tail{0};  // next slot to format
+    std::atomic<bool> owned{true};                      // false once the thread has exited
+    Record slots[kRingRecords];
+};
+
+// The drain thread parks on drainSignal when every ring is empty. Writers only
+// touch it (one syscall) if it is actually parked.
+std::atomic<uint32_t> drainSignal{0};
+std::atomic<uint32_t> drainWaiting{0};
+
+class Logger {
+public:
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        drainSignal.fetch_add(1, std::memory_order_release);
+        drainSignal.notify_all();
+        if (thread_.joinable()) thread_.join();
+        drain();
+    }
+
+    Ring* acquire() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        if (!thread_.joinable()) thread_ = std::thread(&Logger::run, this);
+        // Rings outlive their threads; hand an orphaned one to the new thread.
+        for (const auto& r : rings_) {
+            if (!r->owned.load(std::memory_order_acquire)) {
+                r->owned.store(true, std::memory_order_relaxed);
+                r->cachedTail = r->tail.load(std::memory_order_acquire);
+                return r.get();
+            }
+        }
+        rings_.push_back(std::make_unique<Ring>());
+        return rings_.back().get();
+    }
+
+    // Format every published record; returns how many there were.
+    size_t drain() {
+        std::lock_guard<std::mutex> lock(drainMutex_);
+        snapshot();
+        batch_.clear();
+        uint64_t drops = 0;
+        for (Ring* r : snapshot_) {
+            uint64_t t = r->tail.load(std::memory_order_relaxed);
+            uint64_t h = r->head.load(std::memory_order_acquire);
+            for (; t != h; ++t) batch_.push_back(r->slots[t & (kRingRecords - 1)]);
+            r->tail.store(t, std::memory_order_release);
+            drops += r->dropped.load(std::memory_order_relaxed);
+        }
+        // Rings are appended whole, so a stable sort keeps each thread's
+        // records (and the parts of one long line) in the order written.
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const Record& a, const Record& b) { return a.tsNs < b.tsNs; });
+
+        for (const Record& rec : batch_) {
+            emit(rec.level == Level::Info ? info_ : errors_);
+            appendRecord(rec);
+        }
+        if (drops > reportedDrops_) {
+            Record rec{};
+            rec.event = uint16_t(Event::Dropped);
+            rec.level = Level::Warn;
+            rec.nargs = 1;
+            rec.types[0] = ArgType::U64;
+            rec.args[0] = drops - reportedDrops_;
+            reportedDrops_ = drops;
+            emit(errors_);
+            appendRecord(rec);
+        }
+        emit(nullptr);
+        return batch_.size();
+    }
+
+    void setOutput(FILE* info, FILE* errors) {
+        std::lock_guard<std::mutex> lock(drainMutex_);
+        info_ = info;
+        errors_ = errors;
+    }
+
+    uint64_t written() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        uint64_t n = 0;
+        for (const auto& r : rings_) n += r->head.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    uint64_t dropped() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        uint64_t n = 0;
+        for (const auto& r : rings_) n += r->dropped.load(std::memory_order_relaxed);
+        return n;
+    }
+
+private:
+    void run() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wake_.wait_for(lock, kBatchDelay, [this] { return stopping_.load(); });
+                if (stopping_) return;
+            }
+            if (drain() > 0) continue;  // more may be on the way
+
+            // Idle: park until a writer publishes into an empty ring.
+            drainWaiting.store(1, std::memory_order_seq_cst);
+            uint32_t seen = drainSignal.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pending()) drainSignal.wait(seen, std::memory_order_acquire);
+            drainWaiting.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void snapshot() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        snapshot_.clear();
+        for (const auto& r : rings_) snapshot_.push_back(r.get());
+    }
+
+    bool pending() {
+        std::lock_guard<std::mutex> lock(ringsMutex_);
+        if (stopping_) return true;
+        for (const auto& r : rings_) {
+            if (r->head.load(std::memory_order_relaxed) != r->tail.load(std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    // Switch the pending output to stream `to`, writing out what was queued
+    // for the previous one so stdout and stderr lines keep their order.
+    void emit(FILE* to) {
+        if (to == out_) return;
+        if (out_ && !text_.empty()) {
+            std::fwrite(text_.data(), 1, text_.size(), out_);
+            std::fflush(out_);
+        }
+        text_.clear();
+        out_ = to;
+    }
+
+    void appendRecord(const Record& rec) {
+        const char* fmt = rec.event < kEvents ? kFormats[rec.event] : "[log] unknown event {}";
+        size_t arg = 0;
+        for (const char* p = fmt; *p; ++p) {
+            if (p[0] == '{' && p[1] == '}') {
+                if (arg < rec.nargs) appendArg(rec, arg++);
+                ++p;
+            } else {
+                text_ += *p;
+            }
+        }
+        if (Event(rec.event) != Event::LinePart) text_ += '\n';
+    }
+
+    void appendArg(const Record& rec, size_t i) {
+        char buf[32];
+        int n = 0;
+        switch (rec.types[i]) {
+            case ArgType::I64: n = std::snprintf(buf, sizeof(buf), "%lld", (long long)int64_t(rec.args[i])); break;
+            case ArgType::U64: n = std::snprintf(buf, sizeof(buf), "%llu", (unsigned long long)rec.args[i]); break;
+            case ArgType::F64: {
+                double d;
+                std::memcpy(&d, &rec.args[i], sizeof(d));
+                n = std::snprintf(buf, sizeof(buf), "%g", d);
+                break;
+            }
+            case ArgType::Str: {
+                size_t off = std::min<size_t>(rec.args[i], kTextBytes - 1);
+                text_.append(rec.text + off, strnlen(rec.text + off, kTextBytes - off));
+                return;
+            }
+        }
+        text_.append(buf, size_t(std::max(n, 0)));
+    }
+
+    std::mutex ringsMutex_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+
+    std::mutex drainMutex_;
+    std::vector<Ring*> snapshot_;
+    std::vector<Record> batch_;
+    std::string text_;
+    FILE* out_ = nullptr;
+    FILE* info_ = stdout;
+    FILE* errors_ = stderr;
+    uint64_t reportedDrops_ = 0;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+Logger& logger() {
+    static Logger l;
+    return l;
+}
+
+struct LocalRing {
+    Ring* ring = nullptr;
+    ~LocalRing() {
+        if (ring) ring->owned.store(false, std::memory_order_release);
+    }
+};
+
+thread_local LocalRing local;
+
+} // namespace
+
+const char* format(Event e) {
+    return size_t(e) < kEvents ? kFormats[size_t(e)] : "?";
+}
+
+namespace detail {
+
+Record* claim() {
+    Ring* r = local.ring;
+    if (!r) r = local.ring = logger().acquire();
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    if (h - r->cachedTail == kRingRecords) {
+        r->cachedTail = r->tail.load(std::memory_order_acquire);
+        if (h - r->cachedTail == kRingRecords) {
+            r->dropped.store(r->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    return &r->slots[h & (kRingRecords - 1)];
+}
+
+void commit() {
+    Ring* r = local.ring;
+    r->head.store(r->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    // Pairs with the fence in Logger::run(): either it sees the record or we see it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (drainWaiting.load(std::memory_order_relaxed) != 0 && drainWaiting.exchange(0, std::memory_order_relaxed)) {
+        drainSignal.fetch_add(1, std::memory_order_release);
+        drainSignal.notify_one();
+    }
+}
+
+} // namespace detail
+
+void lines(Level level, std::string_view text) {
+    constexpr size_t kChunk = kTextBytes - 1;
+    const uint64_t ts = util::monotonicNs();
+    while (!text.empty()) {
+        size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text = eol == std::string_view::npos ? std::string_view() : text.substr(eol + 1);
+        do {
+            Record* rec = detail::claim();
+            if (!rec) return;
+            std::string_view part = line.substr(0, kChunk);
+            line.remove_prefix(part.size());
+            rec->tsNs = ts;  // one stamp, so the parts sort together
+            rec->event = uint16_t(line.empty() ? Event::Line : Event::LinePart);
+            rec->level = level;
+            rec->nargs = 0;
+            detail::Encoder{*rec}(part);
+            detail::commit();
+        } while (!line.empty());
+    }
+}
+
+void flush() {
+    logger().drain();
+}
+
+void setOutput(FILE* info, FILE* errors) {
+    flush();
+    logger().setOutput(info, errors);
+}
+
+uint64_t written() {
+    return logger().written();
+}
+
+uint64_t dropped() {
+    return logger().dropped();
+}
+
+} // namespace logging
@@ -0,0 +1,106 @@
+#include "util/Metrics.hpp"
+#include <memory>
+
+namespace metrics {
+
+const char* name(Stage s) {
+    switch (s) {
+        case Stage::Ingress: return "ingress";
+        case Stage::Enqueue: return "enqueue";
+        case Stage::Dequeue: return "dequeue";
+        case Stage::Actuate: return "actuate";
+        case Stage::EndToEnd: return "end_to_end";
+    }
+    return "?";
+}
+
+const char* name(Counter c) {
+    switch (c) {
+        case Counter::Commands: return "commands";
+        case Counter::Unknown: return "unknown";
+        case Counter::Stale: return "stale";
+        case Counter::OutOfOrder: return "out_of_order";
+        case Counter::NotReady: return "not_ready";
+        case Counter::ProtocolErrors: return "protocol_errors";
+        case Counter::Dropped: return "dropped";
+    }
+    return "?";
+}
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+Registry::Shard& Registry::shard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shards_[slot];
+}
+
+uint64_t Registry::counter(Counter c) const {
+    uint64_t n = 0;
+    for (const auto& s : shards_) n += s.counters[size_t(c)].load(std::memory_order_relaxed);
+    return n;
+}
+
+StageSummary Registry::summary(Stage st) const {
+    auto merged = std::make_unique<util::LatencyHistogram>();
+    for (const auto& s : shards_) merged->mergeFrom(s.stages[size_t(st)]);
+
+    StageSummary r;
+    r.count = merged->count();
+    r.mean = merged->mean();
+    r.p50 = merged->percentile(50);
+    r.p90 = merged->percentile(90);
+    r.p99 = merged->percentile(99);
+    r.max = merged->max();
+    return r;
+}
+
+void Registry::reset() {
+    for (auto& s : shards_) {
+        for (auto& h : s.stages) h.reset();
+        for (auto& c : s.counters) c.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Registry::appendJson(std::string& out) const {
+    out += "\"counters\":{";
+    for (size_t i = 0; i < kCounters; ++i) {
+        if (i) out += ',';
+        out += '"';
+        out += name(Counter(i));
+        out += "\":" + std::to_string(counter(Counter(i)));
+    }
+    out += "},\"stages_ns\":{";
+    for (size_t i = 0; i < kStages; ++i) {
+        StageSummary s = summary(Stage(i));
+        if (i) out += ',';
+        out += '"';
+        out += name(Stage(i));
+        out += "\":{\"count\":" + std::to_string(s.count) + ",\"mean\":" + std::to_string(s.mean) +
+               ",\"p50\":" + std::to_string(s.p50) + ",\"p90\":" + std::to_string(s.p90) +
+               ",\"p99\":" + std::to_string(s.p99) + ",\"max\":" + std::to_string(s.max) + "}";
+    }
+    out += '}';
+}
+
+void Registry::appendText(std::string& out) const {
+    for (size_t i = 0; i < kCounters; ++i) {
+        out += "  ";
+        out += name(Counter(i));
+        out += ' ' + std::to_string(counter(Counter(i))) + '\n';
+    }
+    for (size_t i = 0; i < kStages; ++i) {
+        StageSummary s = summary(Stage(i));
+        if (s.count == 0) continue;
+        out += "  ";
+        out += name(Stage(i));
+        out += ": n=" + std::to_string(s.count) + " p50=" + std::to_string(s.p50 / 1000) +
+               "us p99=" + std::to_string(s.p99 / 1000) + "us max=" + std::to_string(s.max / 1000) +
+               "us\n";
+    }
+}
+
+} // namespace metrics